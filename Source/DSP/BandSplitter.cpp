@@ -0,0 +1,89 @@
+/*
+  ==============================================================================
+
+    BandSplitter.cpp
+
+  ==============================================================================
+*/
+
+#include "BandSplitter.h"
+
+BandSplitter::BandSplitter()
+{
+    for (size_t k = 0; k < maxCrossovers; ++k)
+    {
+        lowpass[k].setType(juce::dsp::LinkwitzRileyFilterType::lowpass);
+        highpass[k].setType(juce::dsp::LinkwitzRileyFilterType::highpass);
+
+        for (auto& ap : allpass[k])
+            ap.setType(juce::dsp::LinkwitzRileyFilterType::allpass);
+    }
+}
+
+void BandSplitter::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    for (size_t k = 0; k < maxCrossovers; ++k)
+    {
+        lowpass[k].prepare(spec);
+        highpass[k].prepare(spec);
+
+        for (auto& ap : allpass[k])
+            ap.prepare(spec);
+    }
+
+    reset();
+}
+
+void BandSplitter::reset()
+{
+    for (size_t k = 0; k < maxCrossovers; ++k)
+    {
+        lowpass[k].reset();
+        highpass[k].reset();
+
+        for (auto& ap : allpass[k])
+            ap.reset();
+    }
+}
+
+void BandSplitter::setCrossovers(const std::array<float, maxCrossovers>& frequencies)
+{
+    for (size_t j = 0; j < maxCrossovers; ++j)
+    {
+        lowpass[j].setCutoffFrequency(frequencies[j]);
+        highpass[j].setCutoffFrequency(frequencies[j]);
+
+        for (size_t k = 0; k < j; ++k)
+            allpass[k][j].setCutoffFrequency(frequencies[j]);
+    }
+}
+
+void BandSplitter::split(const juce::dsp::AudioBlock<float>& input,
+                         std::array<juce::dsp::AudioBlock<float>, maxBands>& bandBlocks,
+                         size_t numBands)
+{
+    jassert(numBands >= 2 && numBands <= maxBands);
+
+    //a different band count routes different filters, so stale state would click
+    if (numBands != lastNumBands)
+    {
+        reset();
+        lastNumBands = numBands;
+    }
+
+    auto last = numBands - 1;
+
+    //what is left above the current crossover travels in the top band's block
+    bandBlocks[last].copyFrom(input);
+
+    for (size_t k = 0; k < last; ++k)
+    {
+        bandBlocks[k].copyFrom(bandBlocks[last]);
+
+        lowpass[k].process(juce::dsp::ProcessContextReplacing<float>(bandBlocks[k]));
+        highpass[k].process(juce::dsp::ProcessContextReplacing<float>(bandBlocks[last]));
+
+        for (auto j = k + 1; j < last; ++j)
+            allpass[k][j].process(juce::dsp::ProcessContextReplacing<float>(bandBlocks[k]));
+    }
+}
@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    BandSplitter.h
+    Linkwitz-Riley crossover network for up to four bands.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    Same topology and the same juce::dsp::LinkwitzRileyFilter as the
+    SimpleMultiBandComp crossover. That one is written out inline in its
+    processor for exactly three bands (LP1/AP2/HP1/LP2/HP2), so there is no
+    class to reuse; this is the same network generalised to N bands:
+    band k is the low-pass at crossover k of whatever the previous high-passes
+    left over, and every band below the last crossover is run through the
+    all-pass of each crossover above it. LR4 low + high sums to that all-pass,
+    so adding the bands back together is phase-coherent (flat magnitude, the
+    same phase shift as a chain of all-passes).
+*/
+struct BandSplitter
+{
+    static constexpr size_t maxBands = 4;
+    static constexpr size_t maxCrossovers = maxBands - 1;
+
+    BandSplitter();
+
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset();
+
+    /** frequencies must be ascending; only the first numBands - 1 are used */
+    void setCrossovers(const std::array<float, maxCrossovers>& frequencies);
+
+    /**
+        Splits input into bandBlocks[0 .. numBands). Every band block needs the
+        same size as input; input itself is left untouched.
+    */
+    void split(const juce::dsp::AudioBlock<float>& input,
+               std::array<juce::dsp::AudioBlock<float>, maxBands>& bandBlocks,
+               size_t numBands);
+
+private:
+    using Filter = juce::dsp::LinkwitzRileyFilter<float>;
+
+    std::array<Filter, maxCrossovers> lowpass, highpass;
+
+    //allpass[k][j] compensates band k for crossover j (only j > k is used)
+    std::array<std::array<Filter, maxCrossovers>, maxCrossovers> allpass;
+
+    size_t lastNumBands = 0;
+};
@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    BandWorkerPool.cpp
+
+  ==============================================================================
+*/
+
+#include "BandWorkerPool.h"
+
+BandWorkerPool::BandWorkerPool()
+{
+    auto numWorkers = juce::jlimit(0, maxWorkers, juce::SystemStats::getNumCpus() - 1);
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto* w = workers.add(new Worker(*this));
+
+        if (! w->startRealtimeThread(juce::Thread::RealtimeOptions{}))
+            w->startThread(juce::Thread::Priority::highest);
+    }
+}
+
+BandWorkerPool::~BandWorkerPool()
+{
+    for (auto* w : workers)
+        w->signalThreadShouldExit();
+
+    wakeWorkers.signal(workers.size());
+
+    for (auto* w : workers)
+        w->stopThread(1000);
+}
+
+bool BandWorkerPool::runAvailableJobs()
+{
+    auto ranAny = false;
+    auto c = claim.load(std::memory_order_acquire);
+
+    for (;;)
+    {
+        auto numJobs = c >> 16;
+        auto next = c & 0xffff;
+
+        if (next >= numJobs)
+            return ranAny;
+
+        if (claim.compare_exchange_weak(c, c + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            (*currentJob.load(std::memory_order_acquire))(next);
+            jobsRemaining.fetch_sub(1, std::memory_order_acq_rel);
+            ranAny = true;
+            c = claim.load(std::memory_order_acquire);
+        }
+    }
+}
+
+void BandWorkerPool::run(size_t numJobs, Job& job)
+{
+    if (numJobs == 0)
+        return;
+
+    if (workers.isEmpty() || busy.exchange(true, std::memory_order_acquire))
+    {
+        for (size_t i = 0; i < numJobs; ++i)
+            job(i);
+
+        return;
+    }
+
+    currentJob.store(&job, std::memory_order_relaxed);
+    jobsRemaining.store(static_cast<int>(numJobs), std::memory_order_relaxed);
+    claim.store(packClaim(static_cast<uint32_t>(numJobs), 0), std::memory_order_release);
+
+    //this thread takes one job itself, so wake a worker for each of the others
+    if (auto toWake = juce::jmin(static_cast<int>(numJobs) - 1, workers.size()); toWake > 0)
+        wakeWorkers.signal(toWake);
+
+    runAvailableJobs();
+
+    //only jobs a worker has already picked up can still be running
+    while (jobsRemaining.load(std::memory_order_acquire) > 0)
+        juce::Thread::yield();
+
+    claim.store(0, std::memory_order_relaxed);
+    busy.store(false, std::memory_order_release);
+}
+
+void BandWorkerPool::Worker::run()
+{
+    for (;;)
+    {
+        pool.wakeWorkers.wait();
+
+        if (threadShouldExit())
+            return;
+
+        pool.runAvailableJobs();
+    }
+}
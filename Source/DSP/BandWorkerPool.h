@@ -0,0 +1,67 @@
+/*
+  ==============================================================================
+
+    BandWorkerPool.h
+    Process-wide helper threads for running chain bands in parallel.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "LightweightSemaphore.h"
+
+/**
+    A few realtime-priority threads shared by every plugin instance through a
+    juce::SharedResourcePointer.
+
+    run() never locks, allocates or waits on a worker that has not started:
+    the calling (audio) thread claims jobs from the same atomic counter as the
+    workers, so a sleeping or busy worker only costs parallelism. The caller
+    only ever waits for jobs a worker has already started. If another instance
+    is using the pool, run() simply does every job itself.
+
+    Idle workers block on a semaphore with no timeout; run() signals it once
+    per batch for the jobs it can't start itself, so the pool costs nothing
+    between blocks or while no instance is processing.
+*/
+class BandWorkerPool
+{
+public:
+    using Job = juce::dsp::FixedSizeFunction<64, void(size_t)>;
+
+    static constexpr int maxWorkers = 3;
+
+    BandWorkerPool();
+    ~BandWorkerPool();
+
+    /** runs job(0) .. job(numJobs - 1) and returns once they have all finished */
+    void run(size_t numJobs, Job& job);
+
+    int getNumWorkers() const { return workers.size(); }
+
+private:
+    struct Worker : juce::Thread
+    {
+        explicit Worker(BandWorkerPool& p) : juce::Thread("Band worker"), pool(p) {}
+        void run() override;
+
+        BandWorkerPool& pool;
+    };
+
+    bool runAvailableJobs();
+
+    static constexpr uint32_t packClaim(uint32_t numJobs, uint32_t nextJob) { return (numJobs << 16) | nextJob; }
+
+    //high half: jobs in this batch, low half: next unclaimed job
+    std::atomic<uint32_t> claim { 0 };
+    std::atomic<int> jobsRemaining { 0 };
+    std::atomic<Job*> currentJob { nullptr };
+    std::atomic<bool> busy { false };
+
+    LightweightSemaphore wakeWorkers;
+    juce::OwnedArray<Worker> workers;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (BandWorkerPool)
+};
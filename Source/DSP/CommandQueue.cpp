@@ -0,0 +1,48 @@
+/*
+  ==============================================================================
+
+    CommandQueue.cpp
+
+  ==============================================================================
+*/
+
+#include "CommandQueue.h"
+
+GarbageCollector::GarbageCollector() : juce::Thread("Garbage collector")
+{
+    startThread(juce::Thread::Priority::low);
+}
+
+GarbageCollector::~GarbageCollector()
+{
+    //every source removes itself before going away, so there is nothing left to collect
+    jassert(sources.isEmpty());
+    stopThread(1000);
+}
+
+void GarbageCollector::add(Source* source)
+{
+    const juce::ScopedWriteLock sl(sourcesLock);
+    sources.addIfNotAlreadyThere(source);
+}
+
+void GarbageCollector::remove(Source* source)
+{
+    const juce::ScopedWriteLock sl(sourcesLock);
+    sources.removeFirstMatchingValue(source);
+}
+
+void GarbageCollector::run()
+{
+    while (! threadShouldExit())
+    {
+        {
+            const juce::ScopedReadLock sl(sourcesLock);
+
+            for (auto* source : sources)
+                source->collectGarbage();
+        }
+
+        wait(collectIntervalMs);
+    }
+}
@@ -0,0 +1,165 @@
+/*
+  ==============================================================================
+
+    CommandQueue.h
+    Hands heap objects to the audio thread and takes the ones they replace
+    away to be deleted on a background thread.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    One thread per process that deletes what the audio threads are done with.
+    Hold it through a juce::SharedResourcePointer. Every registered source is
+    asked to free its garbage every collectIntervalMs.
+
+    add() and remove() wait for a collection pass in progress, so only call
+    them when a source is made and destroyed, never from the audio thread.
+*/
+class GarbageCollector : private juce::Thread
+{
+public:
+    static constexpr int collectIntervalMs = 20;
+
+    struct Source
+    {
+        virtual ~Source() = default;
+        /** garbage thread */
+        virtual void collectGarbage() = 0;
+    };
+
+    GarbageCollector();
+    ~GarbageCollector() override;
+
+    void add(Source* source);
+    void remove(Source* source);
+
+private:
+    void run() override;
+
+    juce::ReadWriteLock sourcesLock;
+    juce::Array<Source*> sources;
+
+    JUCE_DECLARE_NON_COPYABLE(GarbageCollector)
+};
+
+//==============================================================================
+/**
+    A single-producer single-consumer queue of owned Objects.
+
+    The producer (usually the message thread) push()es a std::unique_ptr and
+    never waits: when the queue is full push() returns false and leaves the
+    object with the caller. The consumer (the audio thread) pull()s each
+    object into its own state; whatever is left in the pointer afterwards,
+    normally the object it replaced, goes to the GarbageCollector rather than
+    being deleted there.
+
+    Every push holds one of `capacity` slots until the garbage thread has
+    freed what its pull left behind, so the return path can never fill up
+    and the audio thread never has to keep or delete anything itself.
+
+    An object the consumer stops using later than its pull, e.g. once it has
+    faded out, goes back through retire(), which has `capacity` slots of its
+    own.
+*/
+template <typename Object>
+class CommandQueue : private GarbageCollector::Source
+{
+public:
+    explicit CommandQueue(int capacity = 16)
+        : commands(static_cast<size_t>(capacity + 1)), garbage(static_cast<size_t>(capacity + 1)),
+          retired(static_cast<size_t>(capacity + 1)),
+          commandFifo(capacity + 1), garbageFifo(capacity + 1), retiredFifo(capacity + 1), maxOutstanding(capacity)
+    {
+        collector->add(this);
+    }
+
+    ~CommandQueue() override
+    {
+        collector->remove(this);
+
+        //nothing is pulling any more, so whatever is still queued is freed here
+        commandFifo.read(commandFifo.getNumReady()).forEach([this](int index) { delete commands[static_cast<size_t>(index)]; });
+        collectGarbage();
+    }
+
+    /** producer; takes the object and returns true, or returns false and leaves it alone when full */
+    bool push(std::unique_ptr<Object>& object)
+    {
+        if (object == nullptr || outstanding.load(std::memory_order_acquire) >= maxOutstanding)
+            return false;
+
+        outstanding.fetch_add(1, std::memory_order_acq_rel);
+        commandFifo.write(1).forEach([this, &object](int index) { commands[static_cast<size_t>(index)] = object.release(); });
+        return true;
+    }
+
+    /**
+        Consumer. Calls apply(std::unique_ptr<Object>&) for each queued object,
+        oldest first; apply usually swaps it with the one currently in use.
+        Returns how many there were.
+    */
+    template <typename Apply>
+    int pull(Apply&& apply) noexcept
+    {
+        auto numReady = commandFifo.getNumReady();
+
+        if (numReady == 0)
+            return 0;
+
+        commandFifo.read(numReady).forEach([this, &apply](int index)
+        {
+            std::unique_ptr<Object> object(commands[static_cast<size_t>(index)]);
+            apply(object);
+
+            //a slot is free for every object pulled, so this never fails
+            garbageFifo.write(1).forEach([this, &object](int slot) { garbage[static_cast<size_t>(slot)] = object.release(); });
+        });
+
+        return numReady;
+    }
+
+    /** consumer; hands an object it has finished with to the garbage thread, or returns false and keeps it when full */
+    bool retire(std::unique_ptr<Object>& object) noexcept
+    {
+        if (object == nullptr)
+            return true;
+
+        if (retiredFifo.getFreeSpace() == 0)
+            return false;
+
+        retiredFifo.write(1).forEach([this, &object](int index) { retired[static_cast<size_t>(index)] = object.release(); });
+        return true;
+    }
+
+    /** consumer; moves the newest object into current, and the rest and the old current out */
+    bool pullInto(std::unique_ptr<Object>& current) noexcept
+    {
+        return pull([&current](std::unique_ptr<Object>& incoming) { std::swap(current, incoming); }) > 0;
+    }
+
+private:
+    void collectGarbage() override
+    {
+        garbageFifo.read(garbageFifo.getNumReady()).forEach([this](int index)
+        {
+            delete garbage[static_cast<size_t>(index)];
+            outstanding.fetch_sub(1, std::memory_order_acq_rel);
+        });
+
+        retiredFifo.read(retiredFifo.getNumReady()).forEach([this](int index) { delete retired[static_cast<size_t>(index)]; });
+    }
+
+    std::vector<Object*> commands, garbage, retired;
+    juce::AbstractFifo commandFifo, garbageFifo, retiredFifo;
+    const int maxOutstanding;
+    std::atomic<int> outstanding { 0 };
+
+    juce::SharedResourcePointer<GarbageCollector> collector;
+
+    JUCE_DECLARE_NON_COPYABLE(CommandQueue)
+};
@@ -0,0 +1,236 @@
+/*
+  ==============================================================================
+
+    LazyPreparation.h
+    Chain stages that are only prepared once something actually needs them.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "LightweightSemaphore.h"
+
+/**
+    Base for every stage of a BandChain. The audio thread never prepares a
+    stage: when it reaches one that is not ready it raises `wanted` and lets
+    the audio through untouched, and the background preparation thread
+    prepares it a few milliseconds later. `liveThisBlock` latches `ready` once
+    per block so parameter updates and processing agree on which stages run.
+
+    A stage that was passed through while it waited fades in from the dry
+    signal over fadeInSeconds once it goes live, rather than cutting in.
+
+    Every stage processes both channels of a band. While both sides are the
+    same, the chain may run a stage on the left channel alone; `rightStale`
+    then says the right channel's state was left behind, and
+    copyLeftToRight() brings it up to date before the stage runs stereo
+    again.
+*/
+struct LazyStage : juce::dsp::ProcessorBase
+{
+    static constexpr double fadeInSeconds = 0.01;
+
+    std::atomic<bool> ready { false };
+    std::atomic<bool> wanted { false };
+    bool liveThisBlock = false;
+    /** audio thread: set while the stage runs on the left channel only */
+    bool rightStale = false;
+
+    void prepareAndReset(const juce::dsp::ProcessSpec& spec)
+    {
+        prepare(spec);
+        reset();
+        fadeIn.reset(spec.sampleRate, fadeInSeconds);
+        fadeIn.setCurrentAndTargetValue(1.f);
+        rightStale = false;
+        wanted.store(false, std::memory_order_relaxed);
+        ready.store(true, std::memory_order_release);
+    }
+
+    /** never concurrent with the audio thread, so the next prepare starts from scratch */
+    void unprepare()
+    {
+        ready.store(false);
+        wanted.store(false);
+        liveThisBlock = false;
+        rightStale = false;
+        passedThrough = false;
+    }
+
+    /** audio thread; starts the fade in if the stage was passed through until now */
+    void latchReadiness()
+    {
+        auto wasLive = liveThisBlock;
+        liveThisBlock = ready.load(std::memory_order_acquire);
+
+        if (! liveThisBlock)
+            return;
+
+        if (! wasLive && passedThrough)
+        {
+            fadeIn.setCurrentAndTargetValue(0.f);
+            fadeIn.setTargetValue(1.f);
+        }
+
+        passedThrough = false;
+    }
+
+    /**
+        Audio thread, for a stage that is not live but should run: the audio
+        passes through and the stage is asked for. Returns true only when it
+        was not already asked for, which is when the preparation thread needs
+        waking.
+    */
+    bool request()
+    {
+        passedThrough = true;
+        return ! wanted.exchange(true, std::memory_order_relaxed);
+    }
+
+    /**
+        Audio thread; process() for a live stage, blended in from the dry input
+        while it fades in. scratch is where the dry input is kept, and a block
+        it can't hold skips the rest of the fade.
+    */
+    void processLive(const juce::dsp::ProcessContextReplacing<float>& context, juce::dsp::AudioBlock<float> scratch)
+    {
+        auto& block = context.getOutputBlock();
+        auto numChannels = block.getNumChannels();
+        auto numSamples = block.getNumSamples();
+
+        if (fadeIn.isSmoothing() && (context.isBypassed || scratch.getNumChannels() < numChannels || scratch.getNumSamples() < numSamples))
+            fadeIn.setCurrentAndTargetValue(1.f);
+
+        if (! fadeIn.isSmoothing())
+        {
+            process(context);
+            return;
+        }
+
+        auto dry = scratch.getSubsetChannelBlock(0, numChannels).getSubBlock(0, numSamples);
+        dry.copyFrom(block);
+        process(context);
+
+        //wet = dry + (wet - dry) * fade
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            auto gain = fadeIn.getNextValue();
+
+            for (size_t ch = 0; ch < numChannels; ++ch)
+            {
+                auto* wet = block.getChannelPointer(ch);
+                auto* dryIn = dry.getChannelPointer(ch);
+                wet[i] = dryIn[i] + (wet[i] - dryIn[i]) * gain;
+            }
+        }
+    }
+
+    /** audio thread; makes the right channel's state a copy of the left's */
+    virtual void copyLeftToRight() {}
+
+    /** audio thread; true when the two channels' state differ by no more than tolerance anywhere */
+    virtual bool channelsMatch(float tolerance) const
+    {
+        juce::ignoreUnused(tolerance);
+        return false;
+    }
+
+    /** approximate heap use once prepared with spec */
+    virtual size_t getHeapBytes(const juce::dsp::ProcessSpec& spec) const = 0;
+
+private:
+    //audio thread
+    bool passedThrough = false;
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> fadeIn { 1.f };
+};
+
+namespace StereoState
+{
+    /** true when every value in a and b is within tolerance of its partner */
+    template <typename Container>
+    bool matches(const Container& a, const Container& b, float tolerance)
+    {
+        return std::equal(std::begin(a), std::end(a), std::begin(b), std::end(b),
+                          [tolerance](float x, float y) { return std::abs(x - y) <= tolerance; });
+    }
+}
+
+/**
+    One low-priority thread for the whole process, shared through a
+    juce::SharedResourcePointer. It sleeps until someone calls requestPass(),
+    then gives every registered Client one pass to prepare whatever its audio
+    thread asked for. Requests made while a pass is waiting share it.
+
+    add() and remove() wait for a pass in progress, so only call them when a
+    client is made and destroyed, never from the audio thread.
+*/
+class LazyPreparationThread : private juce::Thread
+{
+public:
+    struct Client
+    {
+        virtual ~Client() = default;
+        /** preparation thread */
+        virtual void runPreparationPass() = 0;
+    };
+
+    LazyPreparationThread() : juce::Thread("DSP preparation")
+    {
+        startThread(juce::Thread::Priority::low);
+    }
+
+    ~LazyPreparationThread() override
+    {
+        signalThreadShouldExit();
+        wakeUp.signal();
+        stopThread(2000);
+    }
+
+    void add(Client* client)
+    {
+        const juce::ScopedWriteLock sl(clientsLock);
+        clients.addIfNotAlreadyThere(client);
+    }
+
+    void remove(Client* client)
+    {
+        const juce::ScopedWriteLock sl(clientsLock);
+        clients.removeFirstMatchingValue(client);
+    }
+
+    /** any thread, the audio thread included: never blocks or allocates */
+    void requestPass()
+    {
+        if (! passRequested.exchange(true, std::memory_order_acq_rel))
+            wakeUp.signal();
+    }
+
+private:
+    void run() override
+    {
+        for (;;)
+        {
+            wakeUp.wait();
+
+            if (threadShouldExit())
+                return;
+
+            //cleared first, so a request made during the pass gets a pass of its own
+            passRequested.store(false, std::memory_order_release);
+
+            const juce::ScopedReadLock sl(clientsLock);
+
+            for (auto* client : clients)
+                client->runPreparationPass();
+        }
+    }
+
+    LightweightSemaphore wakeUp;
+    std::atomic<bool> passRequested { false };
+    juce::ReadWriteLock clientsLock;
+    juce::Array<Client*> clients;
+
+    JUCE_DECLARE_NON_COPYABLE(LazyPreparationThread)
+};
@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    LightweightSemaphore.cpp
+
+  ==============================================================================
+*/
+
+#include "LightweightSemaphore.h"
+
+#if JUCE_MAC || JUCE_IOS
+ #include <dispatch/dispatch.h>
+#elif JUCE_WINDOWS
+ #include <windows.h>
+#else
+ #include <semaphore.h>
+ #include <cerrno>
+#endif
+
+LightweightSemaphore::LightweightSemaphore()
+{
+   #if JUCE_MAC || JUCE_IOS
+    native = dispatch_semaphore_create(0);
+   #elif JUCE_WINDOWS
+    native = CreateSemaphoreW(nullptr, 0, std::numeric_limits<LONG>::max(), nullptr);
+   #else
+    auto* s = new sem_t;
+    sem_init(s, 0, 0);
+    native = s;
+   #endif
+}
+
+LightweightSemaphore::~LightweightSemaphore()
+{
+   #if JUCE_MAC || JUCE_IOS
+    dispatch_release(static_cast<dispatch_semaphore_t>(native));
+   #elif JUCE_WINDOWS
+    CloseHandle(native);
+   #else
+    auto* s = static_cast<sem_t*>(native);
+    sem_destroy(s);
+    delete s;
+   #endif
+}
+
+void LightweightSemaphore::signal(int count)
+{
+    jassert(count > 0);
+    auto previous = available.fetch_add(count, std::memory_order_release);
+
+    //only the threads already asleep need the OS to wake them
+    if (auto sleeping = juce::jmin(count, -previous); sleeping > 0)
+        postNative(sleeping);
+}
+
+void LightweightSemaphore::wait()
+{
+    if (available.fetch_sub(1, std::memory_order_acquire) <= 0)
+        waitNative();
+}
+
+void LightweightSemaphore::postNative(int count)
+{
+   #if JUCE_MAC || JUCE_IOS
+    for (int i = 0; i < count; ++i)
+        dispatch_semaphore_signal(static_cast<dispatch_semaphore_t>(native));
+   #elif JUCE_WINDOWS
+    ReleaseSemaphore(native, count, nullptr);
+   #else
+    for (int i = 0; i < count; ++i)
+        sem_post(static_cast<sem_t*>(native));
+   #endif
+}
+
+void LightweightSemaphore::waitNative()
+{
+   #if JUCE_MAC || JUCE_IOS
+    dispatch_semaphore_wait(static_cast<dispatch_semaphore_t>(native), DISPATCH_TIME_FOREVER);
+   #elif JUCE_WINDOWS
+    WaitForSingleObject(native, INFINITE);
+   #else
+    //a signal handler interrupting the wait is not a post
+    while (sem_wait(static_cast<sem_t*>(native)) != 0 && errno == EINTR) {}
+   #endif
+}
@@ -0,0 +1,42 @@
+/*
+  ==============================================================================
+
+    LightweightSemaphore.h
+    A counting semaphore that the audio thread can signal without locking.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    Worker threads block in wait() with no timeout and cost nothing while
+    there is no work. signal() is an atomic add, plus one OS semaphore post
+    per thread that is actually asleep: no mutex, no allocation, so it is safe
+    to call from the audio thread. That OS semaphore is a futex on Linux, a
+    dispatch semaphore on macOS and a kernel semaphore on Windows.
+*/
+class LightweightSemaphore
+{
+public:
+    LightweightSemaphore();
+    ~LightweightSemaphore();
+
+    /** any thread, never blocks; lets count waits through */
+    void signal(int count = 1);
+
+    /** blocks until a signal is available */
+    void wait();
+
+private:
+    void postNative(int count);
+    void waitNative();
+
+    //negative while threads are blocked in waitNative
+    std::atomic<int> available { 0 };
+    void* native = nullptr;
+
+    JUCE_DECLARE_NON_COPYABLE(LightweightSemaphore)
+};
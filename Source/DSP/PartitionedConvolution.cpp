@@ -0,0 +1,640 @@
+/*
+  ==============================================================================
+
+    PartitionedConvolution.cpp
+
+  ==============================================================================
+*/
+
+#include "PartitionedConvolution.h"
+#include "../Diagnostics/TimelineTrace.h"
+
+namespace
+{
+//forward transform of numSamples samples, zero padded to the FFT size; data holds 2 * fftSize floats
+void forwardTransform(const juce::dsp::FFT& fft, float* data, const float* samples, int numSamples)
+{
+    auto fftSize = fft.getSize();
+    std::fill(data, data + 2 * fftSize, 0.f);
+    std::copy(samples, samples + numSamples, data);
+    fft.performRealOnlyForwardTransform(data, true);
+}
+}
+
+//==============================================================================
+std::unique_ptr<ConvolutionEngine> ConvolutionEngine::create(const juce::AudioBuffer<float>& ir, double irSampleRate, double sampleRate)
+{
+    if (ir.getNumChannels() == 0 || ir.getNumSamples() == 0 || irSampleRate <= 0.0 || sampleRate <= 0.0)
+        return nullptr;
+
+    auto numChannels = juce::jmin(2, ir.getNumChannels());
+    auto ratio = irSampleRate / sampleRate;
+    auto length = juce::jmin(static_cast<int>(std::ceil(ir.getNumSamples() / ratio)),
+                             static_cast<int>(maxSeconds * sampleRate));
+
+    juce::AudioBuffer<float> resampled(numChannels, length);
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        if (ratio == 1.0)
+        {
+            resampled.copyFrom(ch, 0, ir, ch, 0, length);
+            continue;
+        }
+
+        juce::LagrangeInterpolator interpolator;
+        interpolator.process(ratio, ir.getReadPointer(ch), resampled.getWritePointer(ch),
+                             length, ir.getNumSamples(), 0);
+    }
+
+    //unit energy, so swapping IRs does not jump in level
+    auto energy = 0.0;
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        auto* data = resampled.getReadPointer(ch);
+
+        for (int i = 0; i < length; ++i)
+            energy += static_cast<double>(data[i]) * data[i];
+    }
+
+    if (energy <= 0.0)
+        return nullptr;
+
+    resampled.applyGain(static_cast<float>(1.0 / std::sqrt(energy / numChannels)));
+
+    return std::unique_ptr<ConvolutionEngine>(new ConvolutionEngine(resampled));
+}
+
+ConvolutionEngine::ConvolutionEngine(const juce::AudioBuffer<float>& ir)
+{
+    numIRChannels = ir.getNumChannels();
+    auto length = ir.getNumSamples();
+    auto headSamples = juce::jmin(length, headLength);
+
+    numHeadParts = (headSamples + headPartition - 1) / headPartition;
+    numTailParts = length > headLength ? (length - headLength + tailPartition - 1) / tailPartition : 0;
+
+    std::vector<float> work(static_cast<size_t>(2 * tailFFTSize));
+
+    for (int ch = 0; ch < numIRChannels; ++ch)
+    {
+        auto* data = ir.getReadPointer(ch);
+
+        auto& head = headSpectra[static_cast<size_t>(ch)];
+        head.resize(static_cast<size_t>(numHeadParts * 2 * headBins));
+
+        for (int k = 0; k < numHeadParts; ++k)
+        {
+            auto start = k * headPartition;
+            forwardTransform(headFFT, work.data(), data + start, juce::jmin(headPartition, headSamples - start));
+            std::copy(work.begin(), work.begin() + 2 * headBins, head.begin() + k * 2 * headBins);
+        }
+
+        auto& tail = tailSpectra[static_cast<size_t>(ch)];
+        tail.resize(static_cast<size_t>(numTailParts * 2 * tailBins));
+
+        for (int k = 0; k < numTailParts; ++k)
+        {
+            auto start = headLength + k * tailPartition;
+            forwardTransform(tailFFT, work.data(), data + start, juce::jmin(tailPartition, length - start));
+            std::copy(work.begin(), work.begin() + 2 * tailBins, tail.begin() + k * 2 * tailBins);
+        }
+    }
+
+    sizeInBytes = sizeof(*this);
+
+    for (size_t ch = 0; ch < channels.size(); ++ch)
+    {
+        auto& c = channels[ch];
+        auto irChannel = juce::jmin(ch, static_cast<size_t>(numIRChannels - 1));
+
+        c.headSpectra = headSpectra[irChannel].data();
+        c.tailSpectra = tailSpectra[irChannel].data();
+
+        c.headInput.assign(static_cast<size_t>(headFFTSize), 0.f);
+        c.headSpectrum.assign(static_cast<size_t>(2 * headFFTSize), 0.f);
+        c.headWork.assign(static_cast<size_t>(2 * headFFTSize), 0.f);
+        c.headAccumulator.assign(static_cast<size_t>(2 * headBins), 0.f);
+        c.headHistory.assign(static_cast<size_t>(numHeadParts * 2 * headBins), 0.f);
+
+        if (numTailParts > 0)
+        {
+            c.tailInput.assign(static_cast<size_t>(tailRingSize), 0.f);
+            c.tailOutput.assign(static_cast<size_t>(tailRingSize), 0.f);
+            c.tailWork.assign(static_cast<size_t>(2 * tailFFTSize), 0.f);
+            c.tailAccumulator.assign(static_cast<size_t>(2 * tailFFTSize), 0.f);
+            c.tailHistory.assign(static_cast<size_t>(numTailParts * 2 * tailBins), 0.f);
+        }
+
+        for (auto* v : { &c.headInput, &c.headSpectrum, &c.headWork, &c.headAccumulator, &c.headHistory,
+                         &c.tailInput, &c.tailOutput, &c.tailWork, &c.tailAccumulator, &c.tailHistory })
+            sizeInBytes += v->size() * sizeof(float);
+    }
+
+    for (auto& spectra : { &headSpectra, &tailSpectra })
+        for (auto& v : *spectra)
+            sizeInBytes += v.size() * sizeof(float);
+
+    //last, so the workers never see a half-built engine
+    if (numTailParts > 0)
+        tailPool->add(this);
+}
+
+ConvolutionEngine::~ConvolutionEngine()
+{
+    if (numTailParts > 0)
+        tailPool->remove(this);
+}
+
+void ConvolutionEngine::multiplyAccumulate(float* acc, const float* a, const float* b, int numBins)
+{
+    for (int i = 0; i < numBins; ++i)
+    {
+        auto re = a[2 * i] * b[2 * i] - a[2 * i + 1] * b[2 * i + 1];
+        auto im = a[2 * i] * b[2 * i + 1] + a[2 * i + 1] * b[2 * i];
+        acc[2 * i] += re;
+        acc[2 * i + 1] += im;
+    }
+}
+
+//==============================================================================
+void ConvolutionEngine::process(size_t channel, const float* input, float* output, int numSamples, bool waitForTail)
+{
+    auto& c = channels[channel];
+
+    //chunks never cross a head frame, and so never cross a tail frame either
+    for (int done = 0; done < numSamples;)
+    {
+        auto chunk = juce::jmin(numSamples - done, headPartition - c.framePos);
+
+        processHead(c, input + done, output + done, chunk);
+
+        if (numTailParts > 0)
+            processTailIO(c, input + done, output + done, chunk, waitForTail);
+
+        done += chunk;
+    }
+}
+
+void ConvolutionEngine::processHead(Channel& c, const float* input, float* output, int numSamples)
+{
+    //headInput holds the previous frame then the one being filled, zero past what has arrived
+    std::copy(input, input + numSamples, c.headInput.begin() + headPartition + c.framePos);
+    forwardTransform(headFFT, c.headSpectrum.data(), c.headInput.data(), headFFTSize);
+
+    std::copy(c.headAccumulator.begin(), c.headAccumulator.end(), c.headWork.begin());
+    std::fill(c.headWork.begin() + 2 * headBins, c.headWork.end(), 0.f);
+    multiplyAccumulate(c.headWork.data(), c.headSpectrum.data(), c.headSpectra, headBins);
+    headFFT.performRealOnlyInverseTransform(c.headWork.data());
+
+    std::copy(c.headWork.begin() + headPartition + c.framePos,
+              c.headWork.begin() + headPartition + c.framePos + numSamples, output);
+
+    c.framePos += numSamples;
+
+    if (c.framePos < headPartition)
+        return;
+
+    //the frame is complete: its spectrum joins the history and the next frame's older partitions are summed now
+    c.framePos = 0;
+    c.headHistoryPos = (c.headHistoryPos + 1) % numHeadParts;
+    std::copy(c.headSpectrum.begin(), c.headSpectrum.begin() + 2 * headBins,
+              c.headHistory.begin() + c.headHistoryPos * 2 * headBins);
+
+    std::copy(c.headInput.begin() + headPartition, c.headInput.end(), c.headInput.begin());
+    std::fill(c.headInput.begin() + headPartition, c.headInput.end(), 0.f);
+
+    std::fill(c.headAccumulator.begin(), c.headAccumulator.end(), 0.f);
+
+    for (int k = 1; k < numHeadParts; ++k)
+    {
+        auto slot = (c.headHistoryPos - (k - 1) + numHeadParts) % numHeadParts;
+        multiplyAccumulate(c.headAccumulator.data(), c.headHistory.data() + slot * 2 * headBins,
+                           c.headSpectra + k * 2 * headBins, headBins);
+    }
+}
+
+void ConvolutionEngine::processTailIO(Channel& c, const float* input, float* output, int numSamples, bool waitForTail)
+{
+    constexpr auto mask = static_cast<juce::int64>(tailRingSize - 1);
+    auto start = c.samplesWritten;
+
+    std::copy(input, input + numSamples, c.tailInput.begin() + (start & mask));
+
+    //the tail's frame j lands headLength samples after the frame started;
+    //if a worker missed that deadline the chunk goes out without its tail rather than waiting
+    if (start >= headLength)
+    {
+        auto frame = (start - headLength) / tailPartition;
+
+        if (frame >= c.firstTailFrame)
+        {
+            while (waitForTail && c.framesDone.load(std::memory_order_acquire) <= frame)
+            {
+                if (! tryProcessTail())
+                    juce::Thread::yield();
+            }
+
+            if (c.framesDone.load(std::memory_order_acquire) > frame)
+            {
+                juce::FloatVectorOperations::add(output, c.tailOutput.data() + (start & mask), numSamples);
+            }
+            else if (frame != c.lastDroppedFrame)
+            {
+                c.lastDroppedFrame = frame;
+                droppedFrames.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    c.samplesWritten += numSamples;
+
+    if (c.samplesWritten % tailPartition == 0)
+    {
+        //sequentially consistent, to pair with the re-check in tryProcessTail
+        c.framesReady.store(c.samplesWritten / tailPartition);
+        //and no ring write after this moves above it, so a worker that still sees the old count read intact input
+        std::atomic_thread_fence(std::memory_order_release);
+        tailPool->notifyFrameReady();
+    }
+}
+
+void ConvolutionEngine::reset()
+{
+    for (auto& c : channels)
+    {
+        //framePos and samplesWritten keep counting, so the head and tail frames stay aligned
+        for (auto* v : { &c.headInput, &c.headAccumulator, &c.headHistory })
+            std::fill(v->begin(), v->end(), 0.f);
+
+        if (numTailParts == 0)
+            continue;
+
+        //the frame being filled already holds old input, but the workers only see it from here on, with that part silenced
+        c.firstTailFrame = c.samplesWritten / tailPartition;
+        c.resetAt.store(c.samplesWritten, std::memory_order_release);
+    }
+}
+
+bool ConvolutionEngine::hasPendingTailFrames() const
+{
+    //framesDone rather than framesProcessed: this runs without the claim
+    for (auto& c : channels)
+        if (c.framesDone.load() < c.framesReady.load())
+            return true;
+
+    return false;
+}
+
+bool ConvolutionEngine::tryProcessTail()
+{
+    auto didWork = false;
+
+    //a frame published while the claim was held belongs to whoever held it: the holder checks
+    //again after letting go, so the wake-up the other worker lost to the claim is never lost to
+    //the frame. The claim and the frame counters are sequentially consistent for that reason.
+    while (hasPendingTailFrames())
+    {
+        auto expected = false;
+
+        if (! tailClaimed.compare_exchange_strong(expected, true))
+            return didWork;
+
+        for (auto& c : channels)
+        {
+            if (c.framesProcessed < c.framesReady.load())
+            {
+                processTailFrames(c);
+                didWork = true;
+            }
+        }
+
+        tailClaimed.store(false);
+    }
+
+    return didWork;
+}
+
+void ConvolutionEngine::processTailFrames(Channel& c)
+{
+    constexpr auto mask = static_cast<juce::int64>(tailRingSize - 1);
+    auto ready = c.framesReady.load(std::memory_order_acquire);
+    //after ready, so a frame published since the reset is never seen without it
+    auto resetAt = c.resetAt.load(std::memory_order_acquire);
+
+    if (resetAt > c.resetHandled)
+    {
+        //nothing from before the reset may reach the output, and the frames in between are never played
+        c.resetHandled = resetAt;
+        std::fill(c.tailHistory.begin(), c.tailHistory.end(), 0.f);
+
+        if (auto firstFrame = resetAt / tailPartition; c.framesProcessed < firstFrame)
+        {
+            c.framesProcessed = firstFrame;
+            c.framesDone.store(firstFrame, std::memory_order_release);
+        }
+    }
+
+    //too far behind to catch up: the input those frames need has been overwritten
+    if (auto skipped = ready - 1 - c.framesProcessed; skipped > 1)
+        skipTailFrames(c, skipped);
+
+    for (; c.framesProcessed < ready; ++c.framesProcessed)
+    {
+        //overlap-save over the previous and the new frame
+        auto firstSample = (c.framesProcessed - 1) * tailPartition;
+        auto first = (c.framesProcessed * tailPartition + 3 * tailPartition) & mask;
+        std::fill(c.tailWork.begin(), c.tailWork.end(), 0.f);
+
+        for (int i = 0; i < 2; ++i)
+        {
+            auto src = c.tailInput.begin() + ((first + i * tailPartition) & mask);
+            std::copy(src, src + tailPartition, c.tailWork.begin() + i * tailPartition);
+        }
+
+        //the audio thread starts overwriting this input once it reaches frame framesProcessed + 3: if it has,
+        //the copy may be torn, so the frame's input counts as silence rather than as a mix of two laps
+        std::atomic_thread_fence(std::memory_order_acquire);
+
+        if (c.framesReady.load(std::memory_order_relaxed) >= c.framesProcessed + 3)
+        {
+            std::fill(c.tailWork.begin(), c.tailWork.end(), 0.f);
+            droppedFrames.fetch_add(1, std::memory_order_relaxed);
+        }
+        else if (firstSample < c.resetHandled)
+        {
+            std::fill_n(c.tailWork.begin(), juce::jmin(c.resetHandled - firstSample, static_cast<juce::int64>(2 * tailPartition)), 0.f);
+        }
+
+        tailFFT.performRealOnlyForwardTransform(c.tailWork.data(), true);
+
+        c.tailHistoryPos = (c.tailHistoryPos + 1) % numTailParts;
+        std::copy(c.tailWork.begin(), c.tailWork.begin() + 2 * tailBins,
+                  c.tailHistory.begin() + c.tailHistoryPos * 2 * tailBins);
+
+        std::fill(c.tailAccumulator.begin(), c.tailAccumulator.end(), 0.f);
+
+        for (int k = 0; k < numTailParts; ++k)
+        {
+            auto slot = (c.tailHistoryPos - k + numTailParts) % numTailParts;
+            multiplyAccumulate(c.tailAccumulator.data(), c.tailHistory.data() + slot * 2 * tailBins,
+                               c.tailSpectra + k * 2 * tailBins, tailBins);
+        }
+
+        tailFFT.performRealOnlyInverseTransform(c.tailAccumulator.data());
+
+        auto destination = (c.framesProcessed * tailPartition + headLength) & mask;
+        std::copy(c.tailAccumulator.begin() + tailPartition, c.tailAccumulator.begin() + 2 * tailPartition,
+                  c.tailOutput.begin() + destination);
+
+        c.framesDone.store(c.framesProcessed + 1, std::memory_order_release);
+    }
+}
+
+void ConvolutionEngine::skipTailFrames(Channel& c, juce::int64 numFrames)
+{
+    constexpr auto mask = static_cast<juce::int64>(tailRingSize - 1);
+
+    //every skipped frame still takes its history slot, empty, so the frames after it
+    //meet the partitions they belong to rather than older input one slot out
+    auto numCleared = static_cast<int>(juce::jmin(numFrames, static_cast<juce::int64>(numTailParts)));
+    c.tailHistoryPos = static_cast<int>((c.tailHistoryPos + numFrames - numCleared) % numTailParts);
+
+    for (int i = 0; i < numCleared; ++i)
+    {
+        c.tailHistoryPos = (c.tailHistoryPos + 1) % numTailParts;
+        std::fill_n(c.tailHistory.begin() + c.tailHistoryPos * 2 * tailBins, 2 * tailBins, 0.f);
+    }
+
+    //their output slots still hold frames from a lap of the ring ago; framesDone will cover them, so silence them
+    auto lastSkipped = c.framesProcessed + numFrames;
+
+    for (auto frame = juce::jmax(c.framesProcessed, lastSkipped - tailRingSize / tailPartition); frame < lastSkipped; ++frame)
+        std::fill_n(c.tailOutput.begin() + ((frame * tailPartition + headLength) & mask), tailPartition, 0.f);
+
+    c.framesProcessed = lastSkipped;
+}
+
+//==============================================================================
+ConvolutionTailPool::ConvolutionTailPool()
+{
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto* worker = workers.add(new Worker(*this));
+
+        //a frame is due a few milliseconds after it is ready, so the workers need the scheduling the audio thread gets
+        if (! worker->startRealtimeThread(juce::Thread::RealtimeOptions{}))
+            worker->startThread(juce::Thread::Priority::highest);
+    }
+}
+
+ConvolutionTailPool::~ConvolutionTailPool()
+{
+    for (auto* worker : workers)
+        worker->signalThreadShouldExit();
+
+    framesReady.signal(workers.size());
+
+    for (auto* worker : workers)
+        worker->stopThread(2000);
+}
+
+void ConvolutionTailPool::add(ConvolutionEngine* engine)
+{
+    const juce::ScopedWriteLock sl(lock);
+    engines.addIfNotAlreadyThere(engine);
+}
+
+void ConvolutionTailPool::remove(ConvolutionEngine* engine)
+{
+    const juce::ScopedWriteLock sl(lock);
+    engines.removeFirstMatchingValue(engine);
+}
+
+bool ConvolutionTailPool::serviceEngines()
+{
+    const juce::ScopedReadLock sl(lock);
+    auto didWork = false;
+
+    for (auto* engine : engines)
+        didWork = engine->tryProcessTail() || didWork;
+
+    return didWork;
+}
+
+void ConvolutionTailPool::Worker::run()
+{
+    for (;;)
+    {
+        pool.framesReady.wait();
+
+        if (threadShouldExit())
+            return;
+
+        pool.serviceEngines();
+    }
+}
+
+//==============================================================================
+ConvolutionStage::~ConvolutionStage()
+{
+    releaseEngines();
+}
+
+void ConvolutionStage::releaseEngines()
+{
+    //the audio thread does not run an unprepared stage, so this thread can pull what it never picked up
+    engineQueue.pull([](std::unique_ptr<ConvolutionEngine>&) {});
+    current.reset();
+    incoming.reset();
+    fadedOut.reset();
+    unsent.reset();
+    offerWaiting = false;
+    engineBytes = 0;
+    droppedByRetired = 0;
+    droppedTailFrames = 0;
+}
+
+void ConvolutionStage::reset()
+{
+    for (auto* engine : { current.get(), incoming.get() })
+        if (engine != nullptr)
+            engine->reset();
+}
+
+void ConvolutionStage::publishDroppedFrames()
+{
+    auto dropped = droppedByRetired;
+
+    for (auto* engine : { current.get(), incoming.get() })
+        if (engine != nullptr)
+            dropped += engine->getNumDroppedFrames();
+
+    droppedTailFrames.store(dropped, std::memory_order_relaxed);
+}
+
+void ConvolutionStage::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    //engines are built for one sample rate, so a new spec means building them again
+    releaseEngines();
+    builtGeneration = -1;
+    crossfade.reset(spec.sampleRate, crossfadeSeconds);
+}
+
+size_t ConvolutionStage::getHeapBytes(const juce::dsp::ProcessSpec&) const
+{
+    return engineBytes.load(std::memory_order_relaxed);
+}
+
+void ConvolutionStage::offerEngine(std::unique_ptr<ConvolutionEngine> engine)
+{
+    engineBytes = engine != nullptr ? engine->getSizeInBytes() : 0;
+
+    //an older engine still waiting never reached the audio thread, so it can go here
+    unsent = std::move(engine);
+    retryOffer();
+}
+
+void ConvolutionStage::retryOffer()
+{
+    if (unsent != nullptr)
+        engineQueue.push(unsent);
+
+    offerWaiting.store(unsent != nullptr, std::memory_order_relaxed);
+}
+
+void ConvolutionStage::takePendingEngine()
+{
+    //one crossfade at a time, and only once the last faded-out engine is on its way to the garbage thread
+    if (fadedOut != nullptr && ! engineQueue.retire(fadedOut))
+        return;
+
+    if (incoming != nullptr)
+        return;
+
+    //oldest first, so the newest engine ends up incoming and the ones it overtook go to the garbage thread
+    engineQueue.pull([this](std::unique_ptr<ConvolutionEngine>& engine) { std::swap(incoming, engine); });
+
+    if (incoming != nullptr)
+    {
+        PROJECT13_TRACE_INSTANT("Convolution engine handoff");
+        crossfade.setCurrentAndTargetValue(0.f);
+        crossfade.setTargetValue(1.f);
+    }
+}
+
+void ConvolutionStage::retireCurrentEngine()
+{
+    if (current != nullptr)
+        droppedByRetired += current->getNumDroppedFrames();
+
+    fadedOut = std::move(current);
+    current = std::move(incoming);
+    engineQueue.retire(fadedOut);
+}
+
+void ConvolutionStage::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    takePendingEngine();
+
+    //nothing is heard while bypassed, so a new engine takes over straight away rather than waiting to fade in
+    if (context.isBypassed)
+    {
+        if (incoming != nullptr)
+        {
+            crossfade.setCurrentAndTargetValue(1.f);
+            retireCurrentEngine();
+        }
+
+        publishDroppedFrames();
+        return;
+    }
+
+    if (current == nullptr && incoming == nullptr)
+        return;
+
+    auto& block = context.getOutputBlock();
+    auto channels = juce::jmin(static_cast<size_t>(numChannels), block.getNumChannels());
+    auto numSamples = static_cast<int>(block.getNumSamples());
+
+    for (int pos = 0; pos < numSamples;)
+    {
+        auto chunk = juce::jmin(numSamples - pos, maxChunk);
+
+        if (incoming != nullptr)
+            for (int i = 0; i < chunk; ++i)
+                ramp[static_cast<size_t>(i)] = crossfade.getNextValue();
+
+        for (size_t ch = 0; ch < channels; ++ch)
+        {
+            auto* io = block.getChannelPointer(ch) + pos;
+            auto* dryCopy = dry[ch].data();
+            juce::FloatVectorOperations::copy(dryCopy, io, chunk);
+
+            if (current != nullptr)
+                current->process(ch, dryCopy, io, chunk, waitForTail);
+            else
+                juce::FloatVectorOperations::clear(io, chunk);
+
+            //io += (incoming - io) * ramp
+            if (incoming != nullptr)
+            {
+                incoming->process(ch, dryCopy, incomingWet.data(), chunk, waitForTail);
+                juce::FloatVectorOperations::subtract(incomingWet.data(), io, chunk);
+                juce::FloatVectorOperations::multiply(incomingWet.data(), ramp.data(), chunk);
+                juce::FloatVectorOperations::add(io, incomingWet.data(), chunk);
+            }
+
+            juce::FloatVectorOperations::multiply(io, mix, chunk);
+            juce::FloatVectorOperations::addWithMultiply(io, dryCopy, 1.f - mix, chunk);
+        }
+
+        if (incoming != nullptr && ! crossfade.isSmoothing())
+            retireCurrentEngine();
+
+        pos += chunk;
+    }
+
+    publishDroppedFrames();
+}
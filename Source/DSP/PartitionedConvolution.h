@@ -0,0 +1,236 @@
+/*
+  ==============================================================================
+
+    PartitionedConvolution.h
+    Non-uniformly partitioned convolution: short partitions on the audio
+    thread, long ones on background workers.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "CommandQueue.h"
+#include "LazyPreparation.h"
+#include "LightweightSemaphore.h"
+
+class ConvolutionEngine;
+
+/**
+    A few realtime-priority threads, shared process-wide, that run the tail
+    partitions of every live engine. Engines add themselves when built and
+    remove themselves when destroyed; removal waits for any worker that is
+    inside the engine. Workers sleep on a semaphore, with no timeout, that
+    the audio thread signals each time it completes a tail frame; signalling
+    it never locks.
+*/
+class ConvolutionTailPool
+{
+public:
+    ConvolutionTailPool();
+    ~ConvolutionTailPool();
+
+    void add(ConvolutionEngine* engine);
+    void remove(ConvolutionEngine* engine);
+
+    /** audio thread, once a tail frame's input is complete */
+    void notifyFrameReady() { framesReady.signal(); }
+
+private:
+    struct Worker : juce::Thread
+    {
+        explicit Worker(ConvolutionTailPool& p) : juce::Thread("Convolution tail"), pool(p) {}
+        void run() override;
+        ConvolutionTailPool& pool;
+    };
+
+    bool serviceEngines();
+
+    static constexpr int numWorkers = 2;
+
+    juce::ReadWriteLock lock;
+    juce::Array<ConvolutionEngine*> engines;
+    LightweightSemaphore framesReady;
+    juce::OwnedArray<Worker> workers;
+};
+
+/**
+    One impulse response, ready to run: its partition spectra plus all the
+    state needed to convolve with it, allocated when the engine is built so
+    nothing is allocated or cleared once the audio thread has it.
+
+    The first headLength samples of the IR are split into headPartition-sized
+    pieces and run on the audio thread with no latency: the spectrum of the
+    frame being filled is recomputed every call, as juce::dsp::Convolution
+    does. The rest is split into tailPartition-sized pieces and run by the
+    tail pool. A tail frame's result is only needed headLength samples after
+    the frame starts, which leaves the workers a whole tail partition of time
+    to compute it, so a multi-second IR costs the audio thread the same as a
+    short one.
+*/
+class ConvolutionEngine
+{
+public:
+    static constexpr int headPartition = 64;
+    static constexpr int tailPartition = 1024;
+    static constexpr int headLength = 2 * tailPartition;
+    static constexpr double maxSeconds = 10.0;
+
+    /** resamples, trims and normalises the IR, then partitions it; call off the audio thread */
+    static std::unique_ptr<ConvolutionEngine> create(const juce::AudioBuffer<float>& ir, double irSampleRate, double sampleRate);
+
+    ~ConvolutionEngine();
+
+    /** audio thread: writes the wet signal for one channel. With waitForTail
+        it runs late tail frames itself instead of leaving them out, for
+        offline rendering where nothing keeps the workers ahead.
+    */
+    void process(size_t channel, const float* input, float* output, int numSamples, bool waitForTail);
+
+    /** audio thread: forgets all input so far. The head is cleared here; the
+        tail pool clears its own state before the first frame after the reset,
+        and tail frames from before it are never played.
+    */
+    void reset();
+
+    /** tail frames that went out without their tail: late to the audio thread, or input lapped under a worker */
+    juce::int64 getNumDroppedFrames() const { return droppedFrames.load(std::memory_order_relaxed); }
+
+    /** tail pool: runs any tail frames that are ready; false if another worker has it or there was nothing to do */
+    bool tryProcessTail();
+
+    size_t getSizeInBytes() const { return sizeInBytes; }
+
+private:
+    explicit ConvolutionEngine(const juce::AudioBuffer<float>& ir);
+
+    //interleaved complex bins, as juce::dsp::FFT's real-only transforms lay them out
+    static void multiplyAccumulate(float* acc, const float* a, const float* b, int numBins);
+
+    struct Channel
+    {
+        //audio thread
+        std::vector<float> headInput, headSpectrum, headWork, headAccumulator, headHistory;
+        int headHistoryPos = 0;
+        int framePos = 0;
+        juce::int64 samplesWritten = 0;
+        //tail frames before this one belong to input from before the last reset
+        juce::int64 firstTailFrame = 0;
+        juce::int64 lastDroppedFrame = -1;
+
+        //shared: written by one side, published through the frame counters
+        std::vector<float> tailInput, tailOutput;
+        std::atomic<juce::int64> framesReady { 0 }, framesDone { 0 };
+        //the sample the last reset happened at; input before it is silence to the tail
+        std::atomic<juce::int64> resetAt { 0 };
+
+        //tail pool
+        std::vector<float> tailWork, tailAccumulator, tailHistory;
+        int tailHistoryPos = 0;
+        juce::int64 framesProcessed = 0;
+        juce::int64 resetHandled = 0;
+
+        const float* headSpectra = nullptr;
+        const float* tailSpectra = nullptr;
+    };
+
+    void processHead(Channel& c, const float* input, float* output, int numSamples);
+    void processTailIO(Channel& c, const float* input, float* output, int numSamples, bool waitForTail);
+    void processTailFrames(Channel& c);
+    bool hasPendingTailFrames() const;
+    void skipTailFrames(Channel& c, juce::int64 numFrames);
+
+    static constexpr int headFFTSize = 2 * headPartition;
+    static constexpr int tailFFTSize = 2 * tailPartition;
+    static constexpr int headBins = headPartition + 1;
+    static constexpr int tailBins = tailPartition + 1;
+    //tail input/output rings: four partitions, so neither side can lap the other within a deadline
+    static constexpr int tailRingSize = 4 * tailPartition;
+
+    static constexpr int headFFTOrder = 7, tailFFTOrder = 11;
+    static_assert((1 << headFFTOrder) == headFFTSize && (1 << tailFFTOrder) == tailFFTSize, "FFT orders must match the partitions");
+
+    juce::dsp::FFT headFFT { headFFTOrder };
+    juce::dsp::FFT tailFFT { tailFFTOrder };
+
+    int numIRChannels = 1;
+    int numHeadParts = 0, numTailParts = 0;
+    std::array<std::vector<float>, 2> headSpectra, tailSpectra;
+    std::array<Channel, 2> channels;
+
+    std::atomic<bool> tailClaimed { false };
+    std::atomic<juce::int64> droppedFrames { 0 };
+    juce::SharedResourcePointer<ConvolutionTailPool> tailPool;
+    size_t sizeInBytes = 0;
+
+    JUCE_DECLARE_NON_COPYABLE(ConvolutionEngine)
+};
+
+/**
+    The chain stage. Processes both channels, like the delay, so a stereo IR
+    can feed each side its own response.
+
+    Engines are built on the preparation thread and handed over through a
+    CommandQueue. The audio thread crossfades from the current engine to the
+    newest one, and the old one is retired through the same queue, so every
+    engine is deleted on the GarbageCollector thread. With no IR loaded the
+    stage passes audio through.
+*/
+class ConvolutionStage : public LazyStage
+{
+public:
+    ~ConvolutionStage() override;
+
+    void prepare(const juce::dsp::ProcessSpec& spec) override;
+    void process(const juce::dsp::ProcessContextReplacing<float>& context) override;
+    /** clears the live engines, so nothing from before a transport reset rings on */
+    void reset() override;
+
+    size_t getHeapBytes(const juce::dsp::ProcessSpec& spec) const override;
+
+    void setMix(float newMix) { mix = juce::jlimit(0.f, 1.f, newMix); }
+    /** set per block from isNonRealtime() */
+    void setWaitForTail(bool shouldWait) { waitForTail = shouldWait; }
+    /** tail frames played without their tail since prepare, over every engine this stage has run */
+    juce::int64 getNumDroppedTailFrames() const { return droppedTailFrames.load(std::memory_order_relaxed); }
+
+    //preparation side
+    /** queues the engine, or keeps it for retryOffer() while the queue is full */
+    void offerEngine(std::unique_ptr<ConvolutionEngine> engine);
+    void retryOffer();
+    /** any thread; true while an engine is waiting for room in the queue */
+    bool isOfferWaiting() const { return offerWaiting.load(std::memory_order_relaxed); }
+    /** which IR load the last offered engine came from; preparation thread only */
+    int builtGeneration = -1;
+
+private:
+    void releaseEngines();
+    void takePendingEngine();
+    /** audio thread; incoming becomes current and the old current goes to the garbage thread */
+    void retireCurrentEngine();
+    void publishDroppedFrames();
+
+    static constexpr int numChannels = 2;
+    static constexpr int maxChunk = 512;
+    static constexpr double crossfadeSeconds = 0.05;
+    static constexpr int engineQueueCapacity = 4;
+
+    CommandQueue<ConvolutionEngine> engineQueue { engineQueueCapacity };
+    //preparation thread: an engine the full queue would not take yet
+    std::unique_ptr<ConvolutionEngine> unsent;
+    std::atomic<bool> offerWaiting { false };
+    //audio thread: fadedOut waits here only if the queue could not retire it straight away
+    std::unique_ptr<ConvolutionEngine> current, incoming, fadedOut;
+    std::atomic<size_t> engineBytes { 0 };
+    //audio thread: what the engines retired since prepare dropped
+    juce::int64 droppedByRetired = 0;
+    std::atomic<juce::int64> droppedTailFrames { 0 };
+
+    float mix = 1.f;
+    bool waitForTail = false;
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Linear> crossfade;
+
+    std::array<std::array<float, maxChunk>, numChannels> dry {};
+    std::array<float, maxChunk> incomingWet {}, ramp {};
+};
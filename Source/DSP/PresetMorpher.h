@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    PresetMorpher.h
+    Interpolates packed parameter snapshots from a single morph position.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    Holds up to maxSnapshots captured parameter sets. Continuous values are
+    blended with two vector ops over the whole packed array; discrete values
+    (choices, bypasses) take the nearer snapshot, so they switch at the
+    midpoint of each segment.
+
+    Snapshot sets are built on the message thread and handed over whole
+    through a CommandQueue; the morpher takes ownership and the set it
+    replaces goes back to be freed on the garbage thread.
+*/
+template<size_t NumFloats, size_t NumDiscretes>
+struct PresetMorpher
+{
+    static constexpr size_t maxSnapshots = 4;
+
+    struct Snapshot
+    {
+        std::array<float, NumFloats> floats {};
+        std::array<float, NumDiscretes> discretes {};
+    };
+
+    struct SnapshotSet
+    {
+        std::array<Snapshot, maxSnapshots> snapshots;
+        std::array<bool, maxSnapshots> captured {};
+    };
+
+    /** audio thread, with a set pulled from the queue; newSet is left holding the old one */
+    void setSnapshots(std::unique_ptr<SnapshotSet>& newSet)
+    {
+        std::swap(set, newSet);
+        numActive = 0;
+
+        if (set == nullptr)
+            return;
+
+        for (size_t i = 0; i < maxSnapshots; ++i)
+            if (set->captured[i])
+                active[numActive++] = i;
+    }
+
+    bool canMorph() const { return numActive >= 2; }
+
+    /**
+        position 0..1 runs through the captured snapshots in slot order.
+        Returns false (and leaves the outputs alone) with fewer than two captured.
+    */
+    bool morph(float position, float* floatsOut, float* discretesOut) const
+    {
+        return morphSlice(position, floatsOut, discretesOut, 0, NumFloats, 0, NumDiscretes);
+    }
+
+    /**
+        Like morph(), but only writes floats [firstFloat, firstFloat + numFloats)
+        and discretes [firstDiscrete, firstDiscrete + numDiscretes), so threads
+        can each re-pack their own disjoint slice of the same arrays.
+    */
+    bool morphSlice(float position, float* floatsOut, float* discretesOut,
+                    size_t firstFloat, size_t numFloats,
+                    size_t firstDiscrete, size_t numDiscretes) const
+    {
+        jassert(firstFloat + numFloats <= NumFloats && firstDiscrete + numDiscretes <= NumDiscretes);
+
+        if (! canMorph())
+            return false;
+
+        auto scaled = juce::jlimit(0.f, 1.f, position) * static_cast<float>(numActive - 1);
+        auto segment = juce::jmin(static_cast<size_t>(scaled), numActive - 2);
+        auto t = scaled - static_cast<float>(segment);
+
+        const auto& a = set->snapshots[active[segment]];
+        const auto& b = set->snapshots[active[segment + 1]];
+
+        juce::FloatVectorOperations::copyWithMultiply(floatsOut + firstFloat, a.floats.data() + firstFloat, 1.f - t, static_cast<int>(numFloats));
+        juce::FloatVectorOperations::addWithMultiply(floatsOut + firstFloat, b.floats.data() + firstFloat, t, static_cast<int>(numFloats));
+
+        const auto& nearest = t < 0.5f ? a : b;
+        std::copy_n(nearest.discretes.data() + firstDiscrete, numDiscretes, discretesOut + firstDiscrete);
+
+        return true;
+    }
+
+private:
+    std::unique_ptr<SnapshotSet> set;
+    std::array<size_t, maxSnapshots> active {};
+    size_t numActive = 0;
+};
@@ -0,0 +1,81 @@
+/*
+  ==============================================================================
+
+    QualityGovernor.cpp
+
+  ==============================================================================
+*/
+
+#include "QualityGovernor.h"
+
+juce::String QualityGovernor::getLevelName(Level level)
+{
+    switch (level)
+    {
+        case Level::Full: return "Full";
+        case Level::Reduced: return "Reduced";
+        case Level::Minimum: return "Minimum";
+    }
+
+    return {};
+}
+
+void QualityGovernor::prepare(double newSampleRate)
+{
+    sampleRate = newSampleRate;
+    smoothedLoad = 0.0;
+    secondsSinceChange = 0.0;
+    secondsBelowStepUp = 0.0;
+    load.store(0.f, std::memory_order_relaxed);
+    setLevel(Level::Full);
+}
+
+void QualityGovernor::setEnabled(bool shouldBeEnabled)
+{
+    if (enabled == shouldBeEnabled)
+        return;
+
+    enabled = shouldBeEnabled;
+
+    if (! enabled)
+        setLevel(Level::Full);
+}
+
+void QualityGovernor::setLevel(Level newLevel)
+{
+    level.store(newLevel, std::memory_order_relaxed);
+    secondsSinceChange = 0.0;
+    secondsBelowStepUp = 0.0;
+}
+
+void QualityGovernor::blockFinished(double elapsedSeconds, int numSamples)
+{
+    if (numSamples <= 0)
+        return;
+
+    auto deadline = numSamples / sampleRate;
+    auto blockLoad = elapsedSeconds / deadline;
+
+    //one-pole smoothing with the same time constant whatever the block size
+    smoothedLoad += (blockLoad - smoothedLoad) * (1.0 - std::exp(-deadline / loadSmoothingSeconds));
+    load.store(static_cast<float>(smoothedLoad), std::memory_order_relaxed);
+
+    if (! enabled)
+        return;
+
+    secondsSinceChange += deadline;
+    secondsBelowStepUp = smoothedLoad < stepUpLoad ? secondsBelowStepUp + deadline : 0.0;
+
+    auto index = static_cast<int>(level.load(std::memory_order_relaxed));
+    auto overran = blockLoad >= 1.0;
+
+    if (index < numLevels - 1
+        && (overran || (smoothedLoad > stepDownLoad && secondsSinceChange >= minDwellSeconds)))
+    {
+        setLevel(static_cast<Level>(index + 1));
+        return;
+    }
+
+    if (index > 0 && secondsBelowStepUp >= stepUpHoldSeconds)
+        setLevel(static_cast<Level>(index - 1));
+}
@@ -0,0 +1,72 @@
+/*
+  ==============================================================================
+
+    QualityGovernor.h
+    Steps processing quality down when blocks come close to their deadline
+    and back up once the load has stayed low for a while.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    The audio thread reports how long each block took. The load is that time
+    over the block's deadline, numSamples / sampleRate, smoothed over about
+    loadSmoothingSeconds so one slow block does not count as pressure, except
+    that a block which overran its deadline steps down at once.
+
+    Stepping down waits minDwellSeconds after the last change so the cheaper
+    level gets the chance to show in the load; stepping up waits until the
+    smoothed load has stayed under stepUpLoad for stepUpHoldSeconds. The gap
+    between the two thresholds and the hold keep it from flapping.
+
+    The levels only change how often modulated values are sampled: the
+    morph's parameters, the SVF's coefficients and the chorus's LFO, which
+    the default chain runs. They never touch any filter or delay state, so a
+    change of level can't click.
+*/
+class QualityGovernor
+{
+public:
+    enum class Level { Full, Reduced, Minimum };
+    static constexpr int numLevels = 3;
+
+    static constexpr float stepDownLoad = 0.75f;
+    static constexpr float stepUpLoad = 0.4f;
+    static constexpr double loadSmoothingSeconds = 0.1;
+    static constexpr double minDwellSeconds = 0.25;
+    static constexpr double stepUpHoldSeconds = 2.0;
+
+    static juce::String getLevelName(Level level);
+
+    /** message thread, from prepareToPlay */
+    void prepare(double newSampleRate);
+
+    /** audio thread; when disabled the level returns to Full and stays there */
+    void setEnabled(bool shouldBeEnabled);
+
+    /** audio thread, after each block */
+    void blockFinished(double elapsedSeconds, int numSamples);
+
+    /** any thread */
+    Level getLevel() const { return level.load(std::memory_order_relaxed); }
+    /** smoothed fraction of the deadline used; any thread */
+    float getLoad() const { return load.load(std::memory_order_relaxed); }
+
+private:
+    void setLevel(Level newLevel);
+
+    double sampleRate = 44100.0;
+    bool enabled = false;
+
+    //audio thread
+    double smoothedLoad = 0.0;
+    double secondsSinceChange = 0.0;
+    double secondsBelowStepUp = 0.0;
+
+    std::atomic<Level> level { Level::Full };
+    std::atomic<float> load { 0.f };
+};
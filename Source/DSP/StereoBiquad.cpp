@@ -0,0 +1,66 @@
+/*
+  ==============================================================================
+
+    StereoBiquad.cpp
+
+  ==============================================================================
+*/
+
+#include "StereoBiquad.h"
+
+void StereoBiquad::setCoefficients(const std::array<float, 6>& coefficients)
+{
+    auto a0 = coefficients[3];
+    auto a0Inv = a0 != 0.f ? 1.f / a0 : 0.f;
+
+    b0 = coefficients[0] * a0Inv;
+    b1 = coefficients[1] * a0Inv;
+    b2 = coefficients[2] * a0Inv;
+    a1 = coefficients[4] * a0Inv;
+    a2 = coefficients[5] * a0Inv;
+}
+
+void StereoBiquad::reset()
+{
+    lv1.fill(0.f);
+    lv2.fill(0.f);
+}
+
+void StereoBiquad::copyLeftToRight()
+{
+    lv1[1] = lv1[0];
+    lv2[1] = lv2[0];
+}
+
+bool StereoBiquad::channelsMatch(float tolerance) const
+{
+    return std::abs(lv1[0] - lv1[1]) <= tolerance && std::abs(lv2[0] - lv2[1]) <= tolerance;
+}
+
+void StereoBiquad::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    auto& block = context.getOutputBlock();
+    auto channels = juce::jmin(static_cast<size_t>(numChannels), block.getNumChannels());
+    auto numSamples = block.getNumSamples();
+    auto bypassed = context.isBypassed;
+
+    for (size_t ch = 0; ch < channels; ++ch)
+    {
+        auto* samples = block.getChannelPointer(ch);
+        auto s1 = lv1[ch], s2 = lv2[ch];
+
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            auto input = samples[i];
+            auto output = input * b0 + s1;
+            samples[i] = bypassed ? input : output;
+            s1 = input * b1 - output * a1 + s2;
+            s2 = input * b2 - output * a2;
+        }
+
+        juce::dsp::util::snapToZero(s1);
+        juce::dsp::util::snapToZero(s2);
+        lv1[ch] = s1;
+        lv2[ch] = s2;
+    }
+}
@@ -0,0 +1,41 @@
+/*
+  ==============================================================================
+
+    StereoBiquad.h
+    The general filter's biquad topology, both channels in one stage.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "LazyPreparation.h"
+
+/**
+    A transposed direct form II biquad, the same as juce::dsp::IIR::Filter
+    with second-order coefficients: bypassed, it still runs so its state
+    follows the input, and a state that has decayed below 1e-8 snaps to zero
+    at the end of every block.
+*/
+class StereoBiquad : public LazyStage
+{
+public:
+    static constexpr int numChannels = 2;
+
+    /** b0, b1, b2, a0, a1, a2, as juce::dsp::IIR::ArrayCoefficients makes them; normalised by a0 here */
+    void setCoefficients(const std::array<float, 6>& coefficients);
+
+    void prepare(const juce::dsp::ProcessSpec&) override { reset(); }
+    void process(const juce::dsp::ProcessContextReplacing<float>& context) override;
+    void reset() override;
+
+    void copyLeftToRight() override;
+    bool channelsMatch(float tolerance) const override;
+    size_t getHeapBytes(const juce::dsp::ProcessSpec&) const override { return 0; }
+
+private:
+    //a pass-through until the first coefficients arrive
+    float b0 = 1.f, b1 = 0.f, b2 = 0.f, a1 = 0.f, a2 = 0.f;
+    std::array<float, numChannels> lv1 {}, lv2 {};
+};
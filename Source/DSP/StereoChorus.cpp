@@ -0,0 +1,184 @@
+/*
+  ==============================================================================
+
+    StereoChorus.cpp
+
+  ==============================================================================
+*/
+
+#include "StereoChorus.h"
+
+StereoChorus::StereoChorus()
+{
+    setRate(1.f);
+    setDepth(0.25f);
+    setCentreDelay(7.f);
+    setFeedback(0.f);
+    setMix(0.5f);
+}
+
+void StereoChorus::setRate(float hz)
+{
+    lfo.setFrequency(hz);
+}
+
+void StereoChorus::setDepth(float newDepth)
+{
+    lfoDepth.setTargetValue(newDepth * 0.5f);
+}
+
+void StereoChorus::setCentreDelay(float ms)
+{
+    centreDelayMs = ms;
+}
+
+void StereoChorus::setFeedback(float newFeedback)
+{
+    feedbackGain.setTargetValue(newFeedback);
+}
+
+void StereoChorus::setMix(float newMix)
+{
+    dryWet.setWetMixProportion(newMix);
+}
+
+int StereoChorus::getLineSize(double sampleRate)
+{
+    //the longest delay at full depth and centre, plus room for the interpolation
+    auto maxDelayMs = maxModulationMs * 0.5 + maxCentreDelayMs;
+    return juce::jmax(4, static_cast<int>(std::ceil(maxDelayMs * sampleRate / 1000.0)) + 2);
+}
+
+size_t StereoChorus::getHeapBytes(const juce::dsp::ProcessSpec& spec) const
+{
+    return numChannels * static_cast<size_t>(getLineSize(spec.sampleRate)) * sizeof(float);
+}
+
+void StereoChorus::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+    lineSize = getLineSize(sampleRate);
+
+    for (auto& line : lines)
+        line.assign(static_cast<size_t>(lineSize), 0.f);
+
+    lfo.prepare(sampleRate);
+    lfoDepth.reset(sampleRate, 0.05);
+    feedbackGain.reset(sampleRate, 0.05);
+    dryWet.prepare(sampleRate);
+    reset();
+}
+
+void StereoChorus::reset()
+{
+    for (auto& line : lines)
+        std::fill(line.begin(), line.end(), 0.f);
+
+    position = 0;
+    lastOutput.fill(0.f);
+    snapRamp = true;
+    lfo.reset();
+    dryWet.reset();
+    lfoDepth.setCurrentAndTargetValue(lfoDepth.getTargetValue());
+    feedbackGain.setCurrentAndTargetValue(feedbackGain.getTargetValue());
+}
+
+void StereoChorus::copyLeftToRight()
+{
+    std::copy(lines[0].begin(), lines[0].end(), lines[1].begin());
+    lastOutput[1] = lastOutput[0];
+}
+
+bool StereoChorus::channelsMatch(float tolerance) const
+{
+    return std::abs(lastOutput[0] - lastOutput[1]) <= tolerance
+        && StereoState::matches(lines[0], lines[1], tolerance);
+}
+
+//==============================================================================
+float StereoChorus::skipToDelaySamples(int numSteps)
+{
+    //the value on the last of the samples, as the reference would have it there
+    lfo.skip(numSteps - 1);
+    lfoDepth.skip(numSteps - 1);
+    auto lfoValue = lfo.getNextValue() * lfoDepth.getNextValue();
+    auto delayMs = juce::jmax(1.f, maxModulationMs * lfoValue + centreDelayMs);
+    return static_cast<float>(delayMs * sampleRate / 1000.0);
+}
+
+void StereoChorus::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    if (context.isBypassed || lineSize == 0)
+        return;
+
+    auto& block = context.getOutputBlock();
+    auto channels = juce::jmin(static_cast<size_t>(numChannels), block.getNumChannels());
+    auto numSamples = block.getNumSamples();
+    auto maxDelay = static_cast<float>(lineSize - 2);
+
+    std::array<float*, numChannels> wet {};
+    std::array<const float*, numChannels> dryIn { dry[0].data(), dry[1].data() };
+
+    for (size_t pos = 0; pos < numSamples; pos += maxChunk)
+    {
+        auto chunk = juce::jmin(static_cast<size_t>(maxChunk), numSamples - pos);
+
+        for (size_t ch = 0; ch < channels; ++ch)
+        {
+            wet[ch] = block.getChannelPointer(ch) + pos;
+            std::copy(wet[ch], wet[ch] + chunk, dry[ch].begin());
+        }
+
+        for (size_t i = 0; i < chunk; i += static_cast<size_t>(controlInterval))
+        {
+            auto run = juce::jmin(static_cast<size_t>(controlInterval), chunk - i);
+            auto target = skipToDelaySamples(static_cast<int>(run));
+
+            if (std::exchange(snapRamp, false))
+                rampDelay = target;
+
+            //from where the last run ended, reaching the target exactly on this run's last sample
+            auto step = (target - rampDelay) / static_cast<float>(run);
+
+            for (size_t j = 0; j + 1 < run; ++j)
+                delaySamples[i + j] = rampDelay + step * static_cast<float>(j + 1);
+
+            delaySamples[i + run - 1] = target;
+            rampDelay = target;
+        }
+
+        for (size_t i = 0; i < chunk; ++i)
+        {
+            auto delay = juce::jlimit(0.f, maxDelay, delaySamples[i]);
+            auto delayInt = static_cast<int>(std::floor(delay));
+            auto frac = delay - static_cast<float>(delayInt);
+
+            auto index1 = position + delayInt;
+            auto index2 = index1 + 1;
+
+            if (index2 >= lineSize)
+            {
+                index1 %= lineSize;
+                index2 %= lineSize;
+            }
+
+            auto feedback = feedbackGain.getNextValue();
+
+            for (size_t ch = 0; ch < channels; ++ch)
+            {
+                auto* line = lines[ch].data();
+                line[position] = wet[ch][i] - lastOutput[ch];
+
+                auto value1 = line[index1];
+                auto output = value1 + frac * (line[index2] - value1);
+
+                wet[ch][i] = output;
+                lastOutput[ch] = output * feedback;
+            }
+
+            position = (position + lineSize - 1) % lineSize;
+        }
+
+        dryWet.mix(wet.data(), dryIn.data(), channels, chunk);
+    }
+}
@@ -0,0 +1,82 @@
+/*
+  ==============================================================================
+
+    StereoChorus.h
+    The chain's chorus, both channels in one stage.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "LazyPreparation.h"
+#include "StereoModulation.h"
+
+/**
+    The same algorithm as juce::dsp::Chorus: a linearly interpolated delay
+    line whose time follows a sine LFO around the centre delay, with feedback
+    and a linear dry/wet mix.
+
+    Both channels share the LFO, the smoothed settings and the delay line's
+    read/write position, which advance once per sample. The left channel can
+    run on its own while the sides are the same; the right one then picks up
+    from a copy of the left's delay line.
+
+    With a control interval above 1 the LFO is only worked out once per
+    interval, and the delay time ramps to it in a straight line in between.
+*/
+class StereoChorus : public LazyStage
+{
+public:
+    static constexpr int numChannels = 2;
+
+    StereoChorus();
+
+    void setRate(float hz);
+    void setDepth(float newDepth);
+    void setCentreDelay(float ms);
+    void setFeedback(float newFeedback);
+    void setMix(float newMix);
+
+    /** audio thread; the LFO every this many samples (1, as JUCE does, to maxChunk), ramped in between */
+    void setControlInterval(int samples) { controlInterval = juce::jlimit(1, maxChunk, samples); }
+
+    void prepare(const juce::dsp::ProcessSpec& spec) override;
+    void process(const juce::dsp::ProcessContextReplacing<float>& context) override;
+    void reset() override;
+
+    void copyLeftToRight() override;
+    bool channelsMatch(float tolerance) const override;
+    size_t getHeapBytes(const juce::dsp::ProcessSpec& spec) const override;
+
+private:
+    static int getLineSize(double sampleRate);
+    /** the delay in samples the LFO asks for numSteps samples on, where it is left */
+    float skipToDelaySamples(int numSteps);
+
+    //ms of delay per unit of LFO output, which full depth swings to plus or minus a half
+    static constexpr float maxModulationMs = 20.f;
+    static constexpr float maxCentreDelayMs = 100.f;
+    static constexpr int maxChunk = 256;
+
+    double sampleRate = 44100.0;
+    float centreDelayMs = 7.f;
+
+    SineLfo lfo;
+    juce::SmoothedValue<float> lfoDepth { 0.125f }, feedbackGain { 0.f };
+    LinearDryWet dryWet;
+    int controlInterval = 1;
+    //where the delay ramp got to at the end of the last run; the first run after a reset starts at its target
+    float rampDelay = 0.f;
+    bool snapRamp = true;
+
+    std::array<std::vector<float>, numChannels> lines;
+    int lineSize = 0;
+    //written, then read from, then stepped back by one every sample
+    int position = 0;
+    std::array<float, numChannels> lastOutput {};
+
+    std::array<float, maxChunk> delaySamples {};
+    std::array<std::array<float, maxChunk>, numChannels> dry {};
+};
@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    StereoLadder.cpp
+
+  ==============================================================================
+*/
+
+#include "StereoLadder.h"
+
+StereoLadder::StereoLadder()
+{
+    setDrive(1.2f);
+}
+
+void StereoLadder::setMode(Mode newMode)
+{
+    if (newMode == mode)
+        return;
+
+    switch (newMode)
+    {
+        case Mode::LPF12: outputMix = {{ 0.f, 0.f, 1.f, 0.f, 0.f }}; compensation = 0.5f; break;
+        case Mode::HPF12: outputMix = {{ 1.f, -2.f, 1.f, 0.f, 0.f }}; compensation = 0.f; break;
+        case Mode::BPF12: outputMix = {{ 0.f, 0.f, -1.f, 1.f, 0.f }}; compensation = 0.5f; break;
+        case Mode::LPF24: outputMix = {{ 0.f, 0.f, 0.f, 0.f, 1.f }}; compensation = 0.5f; break;
+        case Mode::HPF24: outputMix = {{ 1.f, -4.f, 6.f, -4.f, 1.f }}; compensation = 0.f; break;
+        case Mode::BPF24: outputMix = {{ 0.f, 0.f, 1.f, -2.f, 1.f }}; compensation = 0.5f; break;
+    }
+
+    for (auto& tap : outputMix)
+        tap *= 1.2f;
+
+    mode = newMode;
+    reset();
+}
+
+void StereoLadder::setCutoffFrequencyHz(float hz)
+{
+    cutoffHz = hz;
+    updateCutoff();
+}
+
+void StereoLadder::setResonance(float newResonance)
+{
+    resonance = newResonance;
+    scaledResonance.setTargetValue(juce::jmap(resonance, 0.1f, 1.f));
+}
+
+void StereoLadder::setDrive(float newDrive)
+{
+    drive = newDrive;
+    gain = std::pow(drive, -2.642f) * 0.6103f + 0.3903f;
+    drive2 = drive * 0.04f + 0.96f;
+    gain2 = std::pow(drive2, -2.642f) * 0.6103f + 0.3903f;
+}
+
+void StereoLadder::updateCutoff()
+{
+    auto cutoffScaler = static_cast<float>(-2.0 * juce::MathConstants<double>::pi) / sampleRate;
+    cutoffTransform.setTargetValue(std::exp(cutoffHz * cutoffScaler));
+}
+
+void StereoLadder::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = static_cast<float>(spec.sampleRate);
+    cutoffTransform.reset(sampleRate, 0.05);
+    scaledResonance.reset(sampleRate, 0.05);
+    updateCutoff();
+    scaledResonance.setTargetValue(juce::jmap(resonance, 0.1f, 1.f));
+    reset();
+}
+
+void StereoLadder::reset()
+{
+    for (auto& s : state)
+        s.fill(0.f);
+
+    cutoffTransform.setCurrentAndTargetValue(cutoffTransform.getTargetValue());
+    scaledResonance.setCurrentAndTargetValue(scaledResonance.getTargetValue());
+}
+
+void StereoLadder::copyLeftToRight()
+{
+    state[1] = state[0];
+}
+
+bool StereoLadder::channelsMatch(float tolerance) const
+{
+    return StereoState::matches(state[0], state[1], tolerance);
+}
+
+//==============================================================================
+float StereoLadder::processSample(float input, State& s, float a1, float resonanceValue) const
+{
+    const auto& saturate = saturation->table;
+    auto g = 1.f - a1;
+    auto b0 = g * 0.76923076923f;
+    auto b1 = g * 0.23076923076f;
+
+    auto dx = gain * saturate(drive * input);
+    auto a = dx + resonanceValue * -4.f * (gain2 * saturate(drive2 * s[4]) - dx * compensation);
+    auto b = b1 * s[0] + a1 * s[1] + b0 * a;
+    auto c = b1 * s[1] + a1 * s[2] + b0 * b;
+    auto d = b1 * s[2] + a1 * s[3] + b0 * c;
+    auto e = b1 * s[3] + a1 * s[4] + b0 * d;
+
+    s = {{ a, b, c, d, e }};
+    return a * outputMix[0] + b * outputMix[1] + c * outputMix[2] + d * outputMix[3] + e * outputMix[4];
+}
+
+void StereoLadder::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    if (context.isBypassed)
+        return;
+
+    auto& block = context.getOutputBlock();
+    auto channels = juce::jmin(static_cast<size_t>(numChannels), block.getNumChannels());
+    auto numSamples = block.getNumSamples();
+
+    std::array<float*, numChannels> samples {};
+
+    for (size_t ch = 0; ch < channels; ++ch)
+        samples[ch] = block.getChannelPointer(ch);
+
+    for (size_t i = 0; i < numSamples; ++i)
+    {
+        auto a1 = cutoffTransform.getNextValue();
+        auto resonanceValue = scaledResonance.getNextValue();
+
+        for (size_t ch = 0; ch < channels; ++ch)
+            samples[ch][i] = processSample(samples[ch][i], state[ch], a1, resonanceValue);
+    }
+}
@@ -0,0 +1,72 @@
+/*
+  ==============================================================================
+
+    StereoLadder.h
+    The chain's ladder filter and overdrive, both channels in one stage.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "LazyPreparation.h"
+
+/**
+    The same algorithm as juce::dsp::LadderFilter: four one-pole sections
+    with a tanh-saturated input and resonance feedback, mixed per mode.
+
+    The cutoff and resonance glide over 50 ms, advancing once per sample for
+    both channels, so the left channel can run on its own while the sides are
+    the same. The tanh table is built once per process and shared by every
+    ladder, rather than once per filter.
+*/
+class StereoLadder : public LazyStage
+{
+public:
+    static constexpr int numChannels = 2;
+    using Mode = juce::dsp::LadderFilterMode;
+
+    StereoLadder();
+
+    /** a new mode clears the filter, as JUCE's does */
+    void setMode(Mode newMode);
+    void setCutoffFrequencyHz(float hz);
+    void setResonance(float newResonance);
+    void setDrive(float newDrive);
+
+    void prepare(const juce::dsp::ProcessSpec& spec) override;
+    void process(const juce::dsp::ProcessContextReplacing<float>& context) override;
+    void reset() override;
+
+    void copyLeftToRight() override;
+    bool channelsMatch(float tolerance) const override;
+    size_t getHeapBytes(const juce::dsp::ProcessSpec&) const override { return 0; }
+
+private:
+    /** tanh over plus or minus 5, for every ladder in the process */
+    struct Saturation
+    {
+        juce::dsp::LookupTableTransform<float> table { [](float x) { return std::tanh(x); }, -5.f, 5.f, 128 };
+    };
+
+    using State = std::array<float, 5>;
+
+    float processSample(float input, State& s, float a1, float resonanceValue) const;
+    void updateCutoff();
+
+    juce::SharedResourcePointer<Saturation> saturation;
+
+    float sampleRate = 44100.f;
+    float cutoffHz = 200.f;
+    float resonance = 0.f;
+    float drive = 1.2f, gain = 1.f, drive2 = 1.f, gain2 = 1.f;
+
+    Mode mode = Mode::LPF12;
+    //the mode's mix of the five taps, and how much of the input the resonance feedback takes back out
+    State outputMix {{ 0.f, 0.f, 1.2f, 0.f, 0.f }};
+    float compensation = 0.5f;
+
+    juce::SmoothedValue<float> cutoffTransform { 0.f }, scaledResonance { 0.1f };
+    std::array<State, numChannels> state {};
+};
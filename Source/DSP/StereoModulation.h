@@ -0,0 +1,100 @@
+/*
+  ==============================================================================
+
+    StereoModulation.h
+    The LFO and dry/wet mix the phaser and chorus share between their
+    channels.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    A sine LFO that works like juce::dsp::Oscillator with std::sin and no
+    lookup table: the output is sin(phase - pi), and frequency changes glide
+    over 50 ms. One instance drives both channels of a stage, so it advances
+    once per sample however many channels are processed.
+*/
+class SineLfo
+{
+public:
+    void prepare(double newSampleRate)
+    {
+        sampleRate = static_cast<float>(newSampleRate);
+        reset();
+    }
+
+    /** snaps to the target frequency and starts again from the bottom of the wave */
+    void reset()
+    {
+        phase.reset();
+        frequency.reset(sampleRate, 0.05);
+    }
+
+    void setFrequency(float hz) { frequency.setTargetValue(hz); }
+
+    float getNextValue()
+    {
+        auto increment = juce::MathConstants<float>::twoPi / sampleRate;
+        return std::sin(phase.advance(increment * frequency.getNextValue()) - juce::MathConstants<float>::pi);
+    }
+
+    /** moves numSteps samples on without working out the value */
+    void skip(int numSteps)
+    {
+        auto increment = juce::MathConstants<float>::twoPi / sampleRate;
+        phase.advance(increment * frequency.skip(numSteps) * static_cast<float>(numSteps));
+    }
+
+private:
+    float sampleRate = 44100.f;
+    juce::dsp::Phase<float> phase;
+    juce::SmoothedValue<float> frequency { 440.f };
+};
+
+/**
+    juce::dsp::DryWetMixer with the linear rule and no latency: the output is
+    wet * mix + dry * (1 - mix), both gains gliding over 50 ms, shared by
+    every channel.
+*/
+class LinearDryWet
+{
+public:
+    void prepare(double sampleRate)
+    {
+        dryGain.reset(sampleRate, 0.05);
+        wetGain.reset(sampleRate, 0.05);
+    }
+
+    /** snaps both gains to their targets */
+    void reset()
+    {
+        dryGain.setCurrentAndTargetValue(dryGain.getTargetValue());
+        wetGain.setCurrentAndTargetValue(wetGain.getTargetValue());
+    }
+
+    void setWetMixProportion(float mix)
+    {
+        dryGain.setTargetValue(1.f - mix);
+        wetGain.setTargetValue(mix);
+    }
+
+    /** wet holds the processed samples and is mixed in place */
+    void mix(float* const* wet, const float* const* dry, size_t numChannels, size_t numSamples)
+    {
+        for (size_t i = 0; i < numSamples; ++i)
+        {
+            auto wetValue = wetGain.getNextValue();
+            auto dryValue = dryGain.getNextValue();
+
+            for (size_t ch = 0; ch < numChannels; ++ch)
+                wet[ch][i] = wet[ch][i] * wetValue + dry[ch][i] * dryValue;
+        }
+    }
+
+private:
+    juce::SmoothedValue<float> dryGain { 0.f }, wetGain { 1.f };
+};
@@ -0,0 +1,141 @@
+/*
+  ==============================================================================
+
+    StereoPhaser.cpp
+
+  ==============================================================================
+*/
+
+#include "StereoPhaser.h"
+
+StereoPhaser::StereoPhaser()
+{
+    setRate(1.f);
+    setDepth(0.5f);
+    setCentreFrequency(1300.f);
+    setFeedback(0.f);
+    setMix(0.5f);
+}
+
+void StereoPhaser::setRate(float hz)
+{
+    lfo.setFrequency(hz);
+}
+
+void StereoPhaser::setDepth(float newDepth)
+{
+    lfoDepth.setTargetValue(newDepth * 0.5f);
+}
+
+void StereoPhaser::setCentreFrequency(float hz)
+{
+    normCentreFrequency = juce::mapFromLog10(hz, 20.f, 20000.f);
+}
+
+void StereoPhaser::setFeedback(float newFeedback)
+{
+    feedbackGain.setTargetValue(newFeedback);
+}
+
+void StereoPhaser::setMix(float newMix)
+{
+    dryWet.setWetMixProportion(newMix);
+}
+
+void StereoPhaser::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+    lfo.prepare(sampleRate / updateInterval);
+    lfoDepth.reset(sampleRate / updateInterval, 0.05);
+    feedbackGain.reset(sampleRate, 0.05);
+    dryWet.prepare(sampleRate);
+    setCutoff(1000.f);
+    reset();
+}
+
+void StereoPhaser::reset()
+{
+    for (auto& state : allpassState)
+        state.fill(0.f);
+
+    lastOutput.fill(0.f);
+    lfo.reset();
+    dryWet.reset();
+    lfoDepth.setCurrentAndTargetValue(lfoDepth.getTargetValue());
+    feedbackGain.setCurrentAndTargetValue(feedbackGain.getTargetValue());
+    updateCounter = 0;
+}
+
+void StereoPhaser::copyLeftToRight()
+{
+    allpassState[1] = allpassState[0];
+    lastOutput[1] = lastOutput[0];
+}
+
+bool StereoPhaser::channelsMatch(float tolerance) const
+{
+    return StereoState::matches(allpassState[0], allpassState[1], tolerance)
+        && std::abs(lastOutput[0] - lastOutput[1]) <= tolerance;
+}
+
+void StereoPhaser::setCutoff(float hz)
+{
+    auto g = static_cast<float>(std::tan(juce::MathConstants<double>::pi * hz / sampleRate));
+    allpassGain = g / (1.f + g);
+}
+
+//==============================================================================
+void StereoPhaser::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    if (context.isBypassed)
+        return;
+
+    auto& block = context.getOutputBlock();
+    auto channels = juce::jmin(static_cast<size_t>(numChannels), block.getNumChannels());
+    auto numSamples = block.getNumSamples();
+    auto maxCutoff = static_cast<float>(juce::jmin(20000.0, 0.49 * sampleRate));
+
+    std::array<float*, numChannels> wet {};
+    std::array<const float*, numChannels> dryIn { dry[0].data(), dry[1].data() };
+
+    for (size_t pos = 0; pos < numSamples; pos += maxChunk)
+    {
+        auto chunk = juce::jmin(static_cast<size_t>(maxChunk), numSamples - pos);
+
+        for (size_t ch = 0; ch < channels; ++ch)
+        {
+            wet[ch] = block.getChannelPointer(ch) + pos;
+            std::copy(wet[ch], wet[ch] + chunk, dry[ch].begin());
+        }
+
+        for (size_t i = 0; i < chunk; ++i)
+        {
+            if (updateCounter == 0)
+            {
+                auto lfoValue = lfo.getNextValue() * lfoDepth.getNextValue();
+                setCutoff(juce::mapToLog10(juce::jlimit(0.f, 1.f, lfoValue + normCentreFrequency), 20.f, maxCutoff));
+            }
+
+            updateCounter = (updateCounter + 1) % updateInterval;
+            auto feedback = feedbackGain.getNextValue();
+
+            for (size_t ch = 0; ch < channels; ++ch)
+            {
+                auto output = wet[ch][i] - lastOutput[ch];
+
+                for (auto& s : allpassState[ch])
+                {
+                    auto v = allpassGain * (output - s);
+                    auto y = v + s;
+                    s = y + v;
+                    output = 2.f * y - output;
+                }
+
+                wet[ch][i] = output;
+                lastOutput[ch] = output * feedback;
+            }
+        }
+
+        dryWet.mix(wet.data(), dryIn.data(), channels, chunk);
+    }
+}
@@ -0,0 +1,68 @@
+/*
+  ==============================================================================
+
+    StereoPhaser.h
+    The chain's phaser, both channels in one stage.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "LazyPreparation.h"
+#include "StereoModulation.h"
+
+/**
+    The same algorithm as juce::dsp::Phaser: six first-order TPT allpasses
+    whose cutoff follows a sine LFO on a log scale, updated every fourth
+    sample, with feedback around the whole cascade and a linear dry/wet mix.
+
+    The LFO and the smoothed settings are shared by both channels and advance
+    once per sample, so the left channel can run on its own while the sides
+    are the same and the right one picks up from a copy of its state.
+*/
+class StereoPhaser : public LazyStage
+{
+public:
+    static constexpr int numChannels = 2;
+
+    StereoPhaser();
+
+    void setRate(float hz);
+    void setDepth(float newDepth);
+    void setCentreFrequency(float hz);
+    void setFeedback(float newFeedback);
+    void setMix(float newMix);
+
+    void prepare(const juce::dsp::ProcessSpec& spec) override;
+    void process(const juce::dsp::ProcessContextReplacing<float>& context) override;
+    void reset() override;
+
+    void copyLeftToRight() override;
+    bool channelsMatch(float tolerance) const override;
+    size_t getHeapBytes(const juce::dsp::ProcessSpec&) const override { return 0; }
+
+private:
+    void setCutoff(float hz);
+
+    static constexpr int numStages = 6;
+    //the cutoff moves every this many samples, and the LFO runs at that fraction of the sample rate
+    static constexpr int updateInterval = 4;
+    static constexpr int maxChunk = 256;
+
+    double sampleRate = 44100.0;
+    float normCentreFrequency = 0.f;
+
+    SineLfo lfo;
+    juce::SmoothedValue<float> lfoDepth { 0.25f }, feedbackGain { 0.f };
+    LinearDryWet dryWet;
+    int updateCounter = 0;
+
+    //the allpasses' G = g / (1 + g), the same for every stage
+    float allpassGain = 0.f;
+    std::array<std::array<float, numStages>, numChannels> allpassState {};
+    std::array<float, numChannels> lastOutput {};
+
+    std::array<std::array<float, maxChunk>, numChannels> dry {};
+};
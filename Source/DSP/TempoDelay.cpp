@@ -0,0 +1,226 @@
+/*
+  ==============================================================================
+
+    TempoDelay.cpp
+
+  ==============================================================================
+*/
+
+#include "TempoDelay.h"
+
+namespace
+{
+//same order as getNoteDivisionNames()
+constexpr std::array<float, 14> noteDivisionBeats
+{
+    4.f, 3.f, 2.f, 4.f / 3.f,
+    1.5f, 1.f, 2.f / 3.f,
+    0.75f, 0.5f, 1.f / 3.f,
+    0.375f, 0.25f, 1.f / 6.f,
+    0.125f,
+};
+
+float onePoleCoefficient(float cutoffHz, double sampleRate)
+{
+    return 1.f - static_cast<float>(std::exp(-juce::MathConstants<double>::twoPi * cutoffHz / sampleRate));
+}
+}
+
+juce::StringArray TempoDelay::getNoteDivisionNames()
+{
+    return juce::StringArray
+    {
+        "1/1", "1/2.", "1/2", "1/2T",
+        "1/4.", "1/4", "1/4T",
+        "1/8.", "1/8", "1/8T",
+        "1/16.", "1/16", "1/16T",
+        "1/32",
+    };
+}
+
+float TempoDelay::getNoteDivisionBeats(int index)
+{
+    return noteDivisionBeats[static_cast<size_t>(juce::jlimit(0, static_cast<int>(noteDivisionBeats.size()) - 1, index))];
+}
+
+size_t TempoDelay::getRingSize(double sr)
+{
+    return static_cast<size_t>(juce::nextPowerOfTwo(static_cast<int>(std::ceil(maxDelaySeconds * sr)) + 2));
+}
+
+size_t TempoDelay::getHeapBytes(const juce::dsp::ProcessSpec& spec) const
+{
+    return numChannels * getRingSize(spec.sampleRate) * sizeof(float);
+}
+
+//==============================================================================
+void TempoDelay::setSettings(const Settings& newSettings)
+{
+    auto filtersChanged = newSettings.lowCutHz != settings.lowCutHz || newSettings.highCutHz != settings.highCutHz;
+
+    settings = newSettings;
+    settings.feedback = juce::jlimit(0.f, 0.95f, settings.feedback);
+    settings.mix = juce::jlimit(0.f, 1.f, settings.mix);
+
+    auto maxSamples = static_cast<float>(maxDelaySeconds * sampleRate);
+    auto target = juce::jlimit(1.f, maxSamples, settings.delayMs * static_cast<float>(sampleRate / 1000.0));
+
+    //the first time after prepare or reset there is nothing to glide from, and a glide from 0 would sweep the first repeats
+    if (snapToTarget)
+        delaySamples.setCurrentAndTargetValue(target);
+    else
+        delaySamples.setTargetValue(target);
+
+    snapToTarget = false;
+
+    if (filtersChanged)
+        updateFilterCoefficients();
+}
+
+void TempoDelay::updateFilterCoefficients()
+{
+    lowCutCoeff = onePoleCoefficient(settings.lowCutHz, sampleRate);
+    highCutCoeff = onePoleCoefficient(settings.highCutHz, sampleRate);
+}
+
+void TempoDelay::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+
+    auto ringSize = getRingSize(sampleRate);
+    ringMask = ringSize - 1;
+
+    for (auto& ring : rings)
+        ring.assign(ringSize, 0.f);
+
+    delaySamples.reset(sampleRate, 0.1);
+    snapToTarget = true;
+    updateFilterCoefficients();
+}
+
+void TempoDelay::reset()
+{
+    for (auto& ring : rings)
+        std::fill(ring.begin(), ring.end(), 0.f);
+
+    writePos = 0;
+    lowCutState.fill(0.f);
+    highCutState.fill(0.f);
+    snapToTarget = true;
+}
+
+//==============================================================================
+void TempoDelay::readInterpolated(const float* ring, size_t start, float frac, float* dest, int numSamples) const
+{
+    auto ringSize = ringMask + 1;
+
+    for (int i = 0; i < numSamples;)
+    {
+        auto pos = (start + static_cast<size_t>(i)) & ringMask;
+
+        //each output also reads the sample after it, so a run stops one short of the end of the ring
+        auto run = juce::jmin(numSamples - i, static_cast<int>(ringSize - 1 - pos));
+
+        if (run == 0)
+        {
+            dest[i] = ring[pos] * (1.f - frac) + ring[0] * frac;
+            ++i;
+            continue;
+        }
+
+        juce::FloatVectorOperations::copyWithMultiply(dest + i, ring + pos, 1.f - frac, run);
+        juce::FloatVectorOperations::addWithMultiply(dest + i, ring + pos + 1, frac, run);
+        i += run;
+    }
+}
+
+void TempoDelay::writeRing(float* ring, const float* source, int numSamples) const
+{
+    auto first = juce::jmin(numSamples, static_cast<int>(ringMask + 1 - writePos));
+    juce::FloatVectorOperations::copy(ring + writePos, source, first);
+
+    if (first < numSamples)
+        juce::FloatVectorOperations::copy(ring, source + first, numSamples - first);
+}
+
+void TempoDelay::filterFeedback(size_t channel, const float* source, float* dest, int numSamples)
+{
+    auto highCut = highCutState[channel];
+    auto lowCut = lowCutState[channel];
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        highCut += highCutCoeff * (source[i] - highCut);
+        lowCut += lowCutCoeff * (highCut - lowCut);
+        dest[i] = highCut - lowCut;
+    }
+
+    highCutState[channel] = highCut;
+    lowCutState[channel] = lowCut;
+}
+
+void TempoDelay::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    if (context.isBypassed)
+        return;
+
+    auto& block = context.getOutputBlock();
+    auto channels = juce::jmin(static_cast<size_t>(numChannels), block.getNumChannels());
+    auto numSamples = static_cast<int>(block.getNumSamples());
+    auto pingPong = settings.pingPong && channels == 2;
+
+    for (int pos = 0; pos < numSamples;)
+    {
+        auto d = delaySamples.getCurrentValue();
+        auto whole = static_cast<int>(d);
+
+        //a chunk never reads samples it writes itself
+        auto chunk = juce::jmin(numSamples - pos, maxChunk, juce::jmax(1, whole));
+
+        if (delaySamples.isSmoothing())
+            chunk = juce::jmin(chunk, glideChunk);
+
+        //reads sit between start and start + 1, frac of the way to the later sample
+        auto start = (writePos + ringMask + 1 - static_cast<size_t>(whole) - 1) & ringMask;
+        auto frac = 1.f - (d - static_cast<float>(whole));
+
+        std::array<float*, numChannels> loop { feedback[0].data(), feedback[1].data() };
+
+        for (size_t ch = 0; ch < channels; ++ch)
+        {
+            readInterpolated(rings[ch].data(), start, frac, wet[ch].data(), chunk);
+            filterFeedback(ch, wet[ch].data(), loop[ch], chunk);
+        }
+
+        //ping-pong: the input enters on the left and each side's echoes are written to the other side
+        if (pingPong)
+            std::swap(loop[0], loop[1]);
+
+        for (size_t ch = 0; ch < channels; ++ch)
+            juce::FloatVectorOperations::multiply(loop[ch], settings.feedback, chunk);
+
+        if (pingPong)
+        {
+            juce::FloatVectorOperations::addWithMultiply(loop[0], block.getChannelPointer(0) + pos, 0.5f, chunk);
+            juce::FloatVectorOperations::addWithMultiply(loop[0], block.getChannelPointer(1) + pos, 0.5f, chunk);
+        }
+        else
+        {
+            for (size_t ch = 0; ch < channels; ++ch)
+                juce::FloatVectorOperations::add(loop[ch], block.getChannelPointer(ch) + pos, chunk);
+        }
+
+        for (size_t ch = 0; ch < channels; ++ch)
+        {
+            writeRing(rings[ch].data(), loop[ch], chunk);
+
+            auto* io = block.getChannelPointer(ch) + pos;
+            juce::FloatVectorOperations::multiply(io, 1.f - settings.mix, chunk);
+            juce::FloatVectorOperations::addWithMultiply(io, wet[ch].data(), settings.mix, chunk);
+        }
+
+        writePos = (writePos + static_cast<size_t>(chunk)) & ringMask;
+        delaySamples.skip(chunk);
+        pos += chunk;
+    }
+}
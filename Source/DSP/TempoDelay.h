@@ -0,0 +1,85 @@
+/*
+  ==============================================================================
+
+    TempoDelay.h
+    Stereo feedback delay with tempo sync, a filtered feedback loop and
+    ping-pong.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "LazyPreparation.h"
+
+/**
+    Each channel's history lives in a power-of-two ring buffer, so every index
+    is a mask rather than a compare-and-wrap. The block is walked in chunks no
+    longer than the delay itself; inside a chunk every read comes from samples
+    written before it, so the interpolated reads, the feedback writes and the
+    dry/wet mix are all straight runs of FloatVectorOperations. Only the two
+    one-pole feedback filters run sample by sample.
+
+    The cost per sample is the same for any delay time: a longer delay only
+    moves where the read starts.
+
+    Ping-pong feeds each side's echoes into the other, so the chain never
+    runs it on one side alone.
+*/
+class TempoDelay : public LazyStage
+{
+public:
+    static constexpr double maxDelaySeconds = 4.0;
+    static constexpr float minDelayMs = 1.f, maxDelayMs = 2000.f;
+
+    /** the tempo sync choices, shortest last */
+    static juce::StringArray getNoteDivisionNames();
+    /** length of a note division in quarter notes */
+    static float getNoteDivisionBeats(int index);
+
+    struct Settings
+    {
+        float delayMs = 250.f;
+        float feedback = 0.f;
+        float mix = 0.f;
+        float lowCutHz = 20.f;
+        float highCutHz = 20000.f;
+        bool pingPong = false;
+    };
+
+    void setSettings(const Settings& newSettings);
+
+    void prepare(const juce::dsp::ProcessSpec& spec) override;
+    void process(const juce::dsp::ProcessContextReplacing<float>& context) override;
+    void reset() override;
+
+    size_t getHeapBytes(const juce::dsp::ProcessSpec& spec) const override;
+
+private:
+    static size_t getRingSize(double sampleRate);
+    void updateFilterCoefficients();
+
+    void readInterpolated(const float* ring, size_t start, float frac, float* dest, int numSamples) const;
+    void writeRing(float* ring, const float* source, int numSamples) const;
+    void filterFeedback(size_t channel, const float* source, float* dest, int numSamples);
+
+    static constexpr int numChannels = 2;
+    //longest chunk handled at once, and the step while the delay time glides
+    static constexpr int maxChunk = 256;
+    static constexpr int glideChunk = 32;
+
+    double sampleRate = 44100.0;
+    std::array<std::vector<float>, numChannels> rings;
+    size_t ringMask = 0;
+    size_t writePos = 0;
+
+    Settings settings;
+    juce::SmoothedValue<float> delaySamples;
+    //set by prepare and reset, so the next setSettings jumps straight to its delay time
+    bool snapToTarget = true;
+    float lowCutCoeff = 0.f, highCutCoeff = 1.f;
+    std::array<float, numChannels> lowCutState {}, highCutState {};
+
+    std::array<std::array<float, maxChunk>, numChannels> wet {}, feedback {};
+};
@@ -0,0 +1,196 @@
+/*
+  ==============================================================================
+
+    TptSvf.cpp
+
+  ==============================================================================
+*/
+
+#include "TptSvf.h"
+
+void TptSvf::setParameters(Mode newMode, float freqHz, float newQ, float newGainDb)
+{
+    if (newMode != mode)
+        coefficientsHeld = false;
+
+    mode = newMode;
+
+    //the first settings after a reset apply at once rather than gliding in from wherever the last ones were
+    if (snapToTargets)
+    {
+        freq.setCurrentAndTargetValue(freqHz);
+        q.setCurrentAndTargetValue(newQ);
+        gainDb.setCurrentAndTargetValue(newGainDb);
+        rampG = getPrewarpedGain(freqHz);
+        rampK = 1.f / juce::jmax(newQ, 0.01f);
+        rampAmplitude = getAmplitude(newGainDb);
+        coefficientsHeld = false;
+        snapToTargets = false;
+        return;
+    }
+
+    freq.setTargetValue(freqHz);
+    q.setTargetValue(newQ);
+    gainDb.setTargetValue(newGainDb);
+}
+
+void TptSvf::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+    lastFreqHz = -1.f;
+    coefficientsHeld = false;
+    freq.reset(spec.sampleRate, smoothingSeconds);
+    q.reset(spec.sampleRate, smoothingSeconds);
+    gainDb.reset(spec.sampleRate, smoothingSeconds);
+    reset();
+}
+
+void TptSvf::reset()
+{
+    ic1.fill(0.f);
+    ic2.fill(0.f);
+    snapToTargets = true;
+}
+
+void TptSvf::copyLeftToRight()
+{
+    ic1[1] = ic1[0];
+    ic2[1] = ic2[0];
+}
+
+bool TptSvf::channelsMatch(float tolerance) const
+{
+    return std::abs(ic1[0] - ic1[1]) <= tolerance && std::abs(ic2[0] - ic2[1]) <= tolerance;
+}
+
+//==============================================================================
+float TptSvf::getPrewarpedGain(float freqHz)
+{
+    if (freqHz != lastFreqHz)
+    {
+        //just short of nyquist, where tan runs off to infinity
+        auto f = juce::jmin(static_cast<double>(freqHz), sampleRate * 0.49);
+        lastG = static_cast<float>(std::tan(juce::MathConstants<double>::pi * f / sampleRate));
+        lastFreqHz = freqHz;
+    }
+
+    return lastG;
+}
+
+float TptSvf::getAmplitude(float newGainDb)
+{
+    if (newGainDb != lastGainDb)
+    {
+        lastAmplitude = std::pow(10.f, newGainDb / 40.f);
+        lastGainDb = newGainDb;
+    }
+
+    return lastAmplitude;
+}
+
+void TptSvf::makeCoefficients(int numSamples)
+{
+    auto gliding = freq.isSmoothing() || q.isSmoothing() || gainDb.isSmoothing();
+
+    if (! gliding && coefficientsHeld)
+        return;
+
+    //a steady filter fills the whole chunk once, and every chunk after that reuses it
+    if (! gliding)
+        numSamples = maxChunk;
+
+    coefficientsHeld = ! gliding;
+
+    std::array<float, maxChunk> g, amp;
+
+    //from where the last run ended to value, reaching it on the run's last sample
+    auto ramp = [](std::array<float, maxChunk>& dest, size_t first, int run, float& from, float to)
+    {
+        auto step = (to - from) / static_cast<float>(run);
+
+        for (size_t j = 0; j < static_cast<size_t>(run); ++j)
+            dest[first + j] = from + step * static_cast<float>(j + 1);
+
+        from = to;
+    };
+
+    for (int i = 0; i < numSamples; i += controlInterval)
+    {
+        auto run = juce::jmin(controlInterval, numSamples - i);
+        auto first = static_cast<size_t>(i);
+
+        ramp(g, first, run, rampG, getPrewarpedGain(freq.skip(run)));
+        ramp(k, first, run, rampK, 1.f / juce::jmax(q.skip(run), 0.01f));
+        ramp(amp, first, run, rampAmplitude, getAmplitude(gainDb.skip(run)));
+    }
+
+    //the output is dryGain * input + bandGain * bandpass, for every mode
+    switch (mode)
+    {
+        case Mode::Peak:
+            for (size_t i = 0; i < static_cast<size_t>(numSamples); ++i)
+            {
+                k[i] /= amp[i];
+                bandGain[i] = k[i] * (amp[i] * amp[i] - 1.f);
+            }
+            break;
+        case Mode::BandPass:
+            std::copy(k.begin(), k.begin() + numSamples, bandGain.begin());
+            break;
+        case Mode::Notch:
+            for (size_t i = 0; i < static_cast<size_t>(numSamples); ++i)
+                bandGain[i] = -k[i];
+            break;
+        case Mode::AllPass:
+            for (size_t i = 0; i < static_cast<size_t>(numSamples); ++i)
+                bandGain[i] = -2.f * k[i];
+            break;
+    }
+
+    for (size_t i = 0; i < static_cast<size_t>(numSamples); ++i)
+    {
+        a1[i] = 1.f / (1.f + g[i] * (g[i] + k[i]));
+        a2[i] = g[i] * a1[i];
+        a3[i] = g[i] * a2[i];
+    }
+}
+
+void TptSvf::process(const juce::dsp::ProcessContextReplacing<float>& context)
+{
+    if (context.isBypassed)
+        return;
+
+    auto& block = context.getOutputBlock();
+    auto numChannels = juce::jmin(static_cast<size_t>(maxChannels), block.getNumChannels());
+    auto numSamples = static_cast<int>(block.getNumSamples());
+    auto dryGain = mode == Mode::BandPass ? 0.f : 1.f;
+
+    std::array<float*, maxChannels> channels {};
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+        channels[ch] = block.getChannelPointer(ch);
+
+    for (int pos = 0; pos < numSamples; pos += maxChunk)
+    {
+        auto chunk = juce::jmin(maxChunk, numSamples - pos);
+        makeCoefficients(chunk);
+
+        for (size_t i = 0; i < static_cast<size_t>(chunk); ++i)
+        {
+            auto index = static_cast<size_t>(pos) + i;
+
+            for (size_t ch = 0; ch < numChannels; ++ch)
+            {
+                auto v0 = channels[ch][index];
+                auto v3 = v0 - ic2[ch];
+                auto v1 = a1[i] * ic1[ch] + a2[i] * v3;
+                auto v2 = ic2[ch] + a2[i] * ic1[ch] + a3[i] * v3;
+
+                ic1[ch] = 2.f * v1 - ic1[ch];
+                ic2[ch] = 2.f * v2 - ic2[ch];
+
+                channels[ch][index] = dryGain * v0 + bandGain[i] * v1;
+            }
+        }
+    }
+}
@@ -0,0 +1,84 @@
+/*
+  ==============================================================================
+
+    TptSvf.h
+    Topology-preserving-transform state variable filter for the general
+    filter's modes, with per-sample cutoff, Q and gain.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "LazyPreparation.h"
+
+/**
+    The trapezoidal SVF (Simper / Zavalishin). Unlike a direct-form biquad it
+    stays stable and well behaved however fast its cutoff moves, so every
+    parameter glides sample by sample. While gliding, the tan and the gain are
+    worked out once per control interval, and g, k and the amplitude ramp to
+    them in straight lines in between. A filter that isn't gliding keeps its
+    coefficients and works nothing out at all.
+
+    One instance filters both channels of a band. Each chunk is done in two
+    passes: the per-sample coefficients first, as straight loops over arrays
+    with no dependencies between samples, then the two-integrator recursion,
+    which shares each sample's coefficients across the channels with the
+    channel loop innermost.
+
+    Peak, bandpass (0 dB peak), notch and allpass match the RBJ responses the
+    biquad mode makes from the same settings.
+*/
+class TptSvf : public LazyStage
+{
+public:
+    /** the general filter's modes, in parameter order */
+    enum class Mode { Peak, BandPass, Notch, AllPass };
+
+    static constexpr int maxChannels = 2;
+
+    /** targets that the filter glides to over smoothingSeconds */
+    void setParameters(Mode newMode, float freqHz, float q, float gainDb);
+
+    /** audio thread; while gliding, a new tan every this many samples (1 to maxChunk), ramped in between */
+    void setControlInterval(int samples) { controlInterval = juce::jlimit(1, maxChunk, samples); }
+
+    void prepare(const juce::dsp::ProcessSpec& spec) override;
+    void process(const juce::dsp::ProcessContextReplacing<float>& context) override;
+    void reset() override;
+
+    void copyLeftToRight() override;
+    bool channelsMatch(float tolerance) const override;
+    size_t getHeapBytes(const juce::dsp::ProcessSpec&) const override { return 0; }
+
+private:
+    void makeCoefficients(int numSamples);
+    float getPrewarpedGain(float freqHz);
+    float getAmplitude(float newGainDb);
+
+    static constexpr int maxChunk = 64;
+    static constexpr double smoothingSeconds = 0.02;
+
+    double sampleRate = 44100.0;
+    Mode mode = Mode::Peak;
+    bool snapToTargets = true;
+    int controlInterval = 1;
+    //set while the coefficient arrays hold one steady value over the whole of maxChunk
+    bool coefficientsHeld = false;
+
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> freq { 1000.f };
+    juce::SmoothedValue<float> q { 1.f }, gainDb { 0.f };
+
+    //the last tan and amplitude worked out, and what for
+    float lastFreqHz = -1.f, lastG = 0.f;
+    float lastGainDb = 0.f, lastAmplitude = 1.f;
+    //where the ramps got to at the end of the last run
+    float rampG = 0.f, rampK = 1.f, rampAmplitude = 1.f;
+
+    //integrator states
+    std::array<float, maxChannels> ic1 {}, ic2 {};
+
+    //per-sample coefficients for the current chunk
+    std::array<float, maxChunk> a1 {}, a2 {}, a3 {}, k {}, bandGain {};
+};
@@ -0,0 +1,639 @@
+/*
+  ==============================================================================
+
+    GoldenRender.cpp
+
+  ==============================================================================
+*/
+
+#include "GoldenRender.h"
+
+namespace GoldenRender
+{
+namespace
+{
+void setPlain(juce::RangedAudioParameter* param, float value)
+{
+    jassert(param != nullptr);
+    param->setValueNotifyingHost(param->convertTo0to1(value));
+}
+
+void applyAllStagesActive(Project13_NewAudioProcessor& p, size_t band)
+{
+    auto& cp = p.chainParams[band];
+
+    setPlain(cp.phaserRateHz, 0.7f);
+    setPlain(cp.phaserDepthPercent, 0.8f);
+    setPlain(cp.phaserCenterFreqHz, 800.f);
+    setPlain(cp.phaserFeedbackPercent, 0.4f);
+    setPlain(cp.phaserMixPercent, 0.5f);
+
+    setPlain(cp.chorusRateHz, 1.5f);
+    setPlain(cp.chorusDepthPercent, 0.4f);
+    setPlain(cp.chorusCenterDelayMs, 12.f);
+    setPlain(cp.chorusFeedbackPercent, 0.2f);
+    setPlain(cp.chorusMixPercent, 0.5f);
+
+    setPlain(cp.overdriveSaturation, 8.f);
+
+    setPlain(cp.ladderFilterMode, 3.f);
+    setPlain(cp.ladderFilterCutoffHz, 3000.f);
+    setPlain(cp.ladderFilterResonance, 0.3f);
+    setPlain(cp.ladderFilterDrive, 2.f);
+
+    setPlain(cp.generalFilterMode, 0.f);
+    setPlain(cp.generalilterFreqHz, 1200.f);
+    setPlain(cp.generalilterQuality, 2.f);
+    setPlain(cp.generalilterGain, 6.f);
+
+    //free time, so the render does not depend on a host tempo
+    setPlain(cp.delayBypass, 0.f);
+    setPlain(cp.delaySync, 0.f);
+    setPlain(cp.delayTimeMs, 180.f);
+    setPlain(cp.delayFeedbackPercent, 0.45f);
+    setPlain(cp.delayMixPercent, 0.3f);
+    setPlain(cp.delayPingPong, 1.f);
+    //no impulse response is loaded here, so this checks the stage passes audio through untouched
+    setPlain(cp.convolutionBypass, 0.f);
+}
+
+std::atomic<bool> recordingRequested { false };
+juce::File goldenDirectory;
+
+juce::String getCaseName(const Signal& signal, const State& state, const Order& order)
+{
+    return signal.name + "_" + state.name + "_" + order.name;
+}
+
+float toDb(float gain)
+{
+    return juce::Decibels::gainToDecibels(gain, -200.f);
+}
+
+bool writeWav(const juce::File& file, const juce::AudioBuffer<float>& buffer)
+{
+    file.deleteFile();
+    std::unique_ptr<juce::OutputStream> stream = file.createOutputStream();
+
+    if (stream == nullptr)
+        return false;
+
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatWriter> writer (wav.createWriterFor(stream.get(), sampleRate,
+                                                                         static_cast<unsigned int>(buffer.getNumChannels()),
+                                                                         32, {}, 0));
+    if (writer == nullptr)
+        return false;
+
+    //the writer owns the stream from here on
+    stream.release();
+    return writer->writeFromAudioSampleBuffer(buffer, 0, buffer.getNumSamples());
+}
+
+bool readWav(const juce::File& file, juce::AudioBuffer<float>& buffer)
+{
+    juce::WavAudioFormat wav;
+    std::unique_ptr<juce::AudioFormatReader> reader (wav.createReaderFor(file.createInputStream().release(), true));
+
+    if (reader == nullptr)
+        return false;
+
+    buffer.setSize(static_cast<int>(reader->numChannels), static_cast<int>(reader->lengthInSamples));
+    return reader->read(&buffer, 0, buffer.getNumSamples(), 0, true, true);
+}
+}
+
+//==============================================================================
+std::vector<Signal> getSignals()
+{
+    return
+    {
+        { "impulses", [](juce::AudioBuffer<float>& b)
+            {
+                b.clear();
+
+                for (int i = 0; i < b.getNumSamples(); i += b.getNumSamples() / 4)
+                    for (int ch = 0; ch < b.getNumChannels(); ++ch)
+                        b.setSample(ch, i, 1.f);
+            } },
+
+        { "sweep", [](juce::AudioBuffer<float>& b)
+            {
+                //log sine sweep 20 Hz - 20 kHz at -6 dBFS, right channel at half level
+                auto n = b.getNumSamples();
+                auto k = std::log(1000.0);
+                auto duration = n / sampleRate;
+
+                for (int i = 0; i < n; ++i)
+                {
+                    auto t = i / sampleRate;
+                    auto phase = juce::MathConstants<double>::twoPi * 20.0 * duration / k * (std::exp(k * t / duration) - 1.0);
+                    auto s = static_cast<float>(0.5 * std::sin(phase));
+                    b.setSample(0, i, s);
+
+                    if (b.getNumChannels() > 1)
+                        b.setSample(1, i, s * 0.5f);
+                }
+            } },
+
+        { "noise", [](juce::AudioBuffer<float>& b)
+            {
+                juce::Random r(1234);
+
+                for (int ch = 0; ch < b.getNumChannels(); ++ch)
+                    for (int i = 0; i < b.getNumSamples(); ++i)
+                        b.setSample(ch, i, (r.nextFloat() * 2.f - 1.f) * 0.25f);
+            } },
+    };
+}
+
+std::vector<State> getStates()
+{
+    return
+    {
+        { "defaults", [](Project13_NewAudioProcessor&) {} },
+
+        { "allStages", [](Project13_NewAudioProcessor& p) { applyAllStagesActive(p, 0); } },
+
+        { "allBypassed", [](Project13_NewAudioProcessor& p)
+            {
+                auto& cp = p.chainParams[0];
+
+                for (auto* bypass : { cp.phaserBypass, cp.chorusBypass, cp.overdriveBypass,
+                                      cp.ladderFilterBypass, cp.generalFilterBypass, cp.delayBypass, cp.convolutionBypass })
+                    setPlain(bypass, 1.f);
+            } },
+
+        { "generalFilterSvf", [](Project13_NewAudioProcessor& p)
+            {
+                applyAllStagesActive(p, 0);
+                setPlain(p.chainParams[0].generalFilterTopology, 1.f);
+            } },
+
+        { "monoPathOff", [](Project13_NewAudioProcessor& p)
+            {
+                applyAllStagesActive(p, 0);
+                setPlain(p.monoPath, 0.f);
+            } },
+
+        { "multiband3", [](Project13_NewAudioProcessor& p)
+            {
+                setPlain(p.multibandMode, 2.f);
+                setPlain(p.crossoverFreqHz[0], 300.f);
+                setPlain(p.crossoverFreqHz[1], 3000.f);
+                applyAllStagesActive(p, 1);
+                setPlain(p.chainParams[2].overdriveSaturation, 20.f);
+            } },
+
+        { "morphHalfway", [](Project13_NewAudioProcessor& p)
+            {
+                p.captureMorphSnapshot(0);
+                applyAllStagesActive(p, 0);
+                p.captureMorphSnapshot(1);
+                setPlain(p.morphEnabled, 1.f);
+                setPlain(p.morphPosition, 0.5f);
+            } },
+    };
+}
+
+std::vector<Order> getOrders()
+{
+    using DSP_Option = Project13_NewAudioProcessor::DSP_Option;
+
+    return
+    {
+        { "forward", {{ DSP_Option::Phase, DSP_Option::Chorus, DSP_Option::Overdrive,
+                        DSP_Option::LadderFilter, DSP_Option::GeneralFilter, DSP_Option::Delay,
+                        DSP_Option::Convolution }} },
+        { "reversed", {{ DSP_Option::Convolution, DSP_Option::Delay, DSP_Option::GeneralFilter, DSP_Option::LadderFilter,
+                         DSP_Option::Overdrive, DSP_Option::Chorus, DSP_Option::Phase }} },
+    };
+}
+
+juce::File getGoldenDirectory()
+{
+    if (goldenDirectory != juce::File())
+        return goldenDirectory;
+
+    auto fromEnv = juce::SystemStats::getEnvironmentVariable("PROJECT13_GOLDEN_DIR", {});
+
+    if (fromEnv.isNotEmpty())
+        return juce::File::getCurrentWorkingDirectory().getChildFile(fromEnv);
+
+    return {};
+}
+
+void setGoldenDirectory(const juce::File& directory)
+{
+    goldenDirectory = directory;
+}
+
+bool isRecording()
+{
+    return recordingRequested.load() || juce::SystemStats::getEnvironmentVariable("PROJECT13_UPDATE_GOLDEN", {}) == "1";
+}
+
+void setRecording(bool shouldRecord)
+{
+    recordingRequested = shouldRecord;
+}
+
+//==============================================================================
+double render(const Signal& signal, const State& state, const Order& order, juce::AudioBuffer<float>& output,
+              const RenderOptions& options)
+{
+    juce::AudioBuffer<float> input(numChannels, lengthSamples);
+    signal.generate(input);
+
+    auto best = std::numeric_limits<double>::max();
+
+    for (int run = 0; run < timingRepeats; ++run)
+    {
+        //a fresh instance every run so no state carries over between renders
+        Project13_NewAudioProcessor processor;
+        processor.setPlayConfigDetails(numChannels, numChannels, sampleRate, options.hostBlockSize);
+        processor.setNonRealtime(options.nonRealtime);
+        processor.setTileSize(options.tileSize);
+        state.apply(processor);
+
+        for (size_t band = 0; band < Project13_NewAudioProcessor::maxBands; ++band)
+            processor.requestDSPOrder(band, order.order);
+
+        processor.prepareToPlay(sampleRate, options.hostBlockSize);
+        output.makeCopyOf(input);
+
+        juce::MidiBuffer midi;
+        auto start = juce::Time::getHighResolutionTicks();
+
+        for (int pos = 0; pos < lengthSamples; pos += options.hostBlockSize)
+        {
+            auto n = juce::jmin(options.hostBlockSize, lengthSamples - pos);
+            juce::AudioBuffer<float> block(output.getArrayOfWritePointers(), numChannels, pos, n);
+            processor.processBlock(block, midi);
+        }
+
+        auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        best = juce::jmin(best, elapsed * 1000.0);
+
+        processor.releaseResources();
+    }
+
+    return best;
+}
+
+Result check(const Signal& signal, const State& state, const Order& order, bool record)
+{
+    Result result;
+    result.caseName = getCaseName(signal, state, order);
+
+    juce::AudioBuffer<float> output;
+    result.renderMs = render(signal, state, order, output);
+
+    auto dir = getGoldenDirectory();
+    auto wavFile = dir.getChildFile(result.caseName + ".wav");
+    auto timingFile = dir.getChildFile(result.caseName + ".json");
+
+    juce::AudioBuffer<float> golden;
+
+    if (record)
+    {
+        dir.createDirectory();
+
+        juce::DynamicObject::Ptr timing (new juce::DynamicObject());
+        timing->setProperty("renderMs", result.renderMs);
+        timing->setProperty("sampleRate", sampleRate);
+        timing->setProperty("blockSize", blockSize);
+
+        result.recorded = writeWav(wavFile, output)
+                       && timingFile.replaceWithText(juce::JSON::toString(juce::var(timing.get())));
+        result.passed = result.recorded;
+        result.message = result.recorded ? "recorded" : "could not write " + wavFile.getFullPathName();
+        return result;
+    }
+
+    //a missing golden is a failure, otherwise a fresh checkout could never fail
+    if (! wavFile.existsAsFile() || ! readWav(wavFile, golden))
+    {
+        result.passed = false;
+        result.message = "no golden file at " + wavFile.getFullPathName() + ", record with --record-golden";
+        return result;
+    }
+
+    if (golden.getNumChannels() != output.getNumChannels() || golden.getNumSamples() != output.getNumSamples())
+    {
+        result.passed = false;
+        result.message = "golden file has a different size";
+        return result;
+    }
+
+    auto peak = 0.f;
+    auto sumSquares = 0.0;
+
+    for (int ch = 0; ch < output.getNumChannels(); ++ch)
+    {
+        auto* out = output.getReadPointer(ch);
+        auto* ref = golden.getReadPointer(ch);
+
+        for (int i = 0; i < output.getNumSamples(); ++i)
+        {
+            auto diff = out[i] - ref[i];
+            peak = juce::jmax(peak, std::abs(diff));
+            sumSquares += static_cast<double>(diff) * diff;
+        }
+    }
+
+    auto totalSamples = static_cast<double>(output.getNumChannels() * output.getNumSamples());
+    result.peakErrorDb = toDb(peak);
+    result.rmsErrorDb = toDb(static_cast<float>(std::sqrt(sumSquares / totalSamples)));
+
+    auto timing = juce::JSON::parse(timingFile);
+    result.goldenMs = static_cast<double>(timing.getProperty("renderMs", 0.0));
+
+    //the time is only reported: the golden one was measured on another machine
+    result.passed = result.peakErrorDb <= maxPeakErrorDb;
+
+    if (! result.passed)
+        result.message << "output differs by " << juce::String(result.peakErrorDb, 1) << " dBFS peak";
+
+    return result;
+}
+
+std::vector<Result> checkAll(bool record)
+{
+    std::vector<Result> results;
+
+    for (const auto& signal : getSignals())
+        for (const auto& state : getStates())
+            for (const auto& order : getOrders())
+                results.push_back(check(signal, state, order, record));
+
+    return results;
+}
+
+juce::String formatTable(const std::vector<Result>& results)
+{
+    juce::String table;
+    table << juce::String("case").paddedRight(' ', 36)
+          << juce::String("peak dB").paddedLeft(' ', 10)
+          << juce::String("rms dB").paddedLeft(' ', 10)
+          << juce::String("ms").paddedLeft(' ', 10)
+          << juce::String("golden ms").paddedLeft(' ', 11)
+          << juce::String("ratio").paddedLeft(' ', 8)
+          << "  result" << juce::newLine;
+
+    for (const auto& r : results)
+    {
+        table << r.caseName.paddedRight(' ', 36)
+              << juce::String(r.peakErrorDb, 1).paddedLeft(' ', 10)
+              << juce::String(r.rmsErrorDb, 1).paddedLeft(' ', 10)
+              << juce::String(r.renderMs, 2).paddedLeft(' ', 10)
+              << juce::String(r.goldenMs, 2).paddedLeft(' ', 11)
+              << (r.goldenMs > 0.0 ? juce::String(r.renderMs / r.goldenMs, 2) + "x" : juce::String("-")).paddedLeft(' ', 8)
+              << "  " << (r.recorded ? "recorded" : r.passed ? "ok" : "FAIL " + r.message)
+              << juce::newLine;
+    }
+
+    return table;
+}
+
+//==============================================================================
+std::vector<int> getTileSizes()
+{
+    auto fromEnv = juce::SystemStats::getEnvironmentVariable("PROJECT13_TILE_SIZES", {});
+
+    if (fromEnv.isEmpty())
+        return { 128, 256, 512, 1024, 2048, 4096 };
+
+    std::vector<int> sizes;
+
+    for (const auto& token : juce::StringArray::fromTokens(fromEnv, ",", {}))
+    {
+        if (auto size = token.trim().getIntValue(); size > 0)
+            sizes.push_back(size);
+    }
+
+    return sizes;
+}
+
+std::vector<TileTiming> benchmarkTileSizes(const Signal& signal, const State& state, const Order& order,
+                                           const std::vector<int>& tileSizes)
+{
+    RenderOptions options;
+    options.hostBlockSize = tileBenchmarkBlockSize;
+    options.nonRealtime = true;
+    options.tileSize = 0;
+
+    std::vector<TileTiming> timings;
+    juce::AudioBuffer<float> reference, output;
+    timings.push_back({ 0, render(signal, state, order, reference, options), -200.f });
+
+    for (auto size : tileSizes)
+    {
+        if (size <= 0)
+            continue;
+
+        options.tileSize = size;
+        TileTiming timing;
+        timing.tileSize = size;
+        timing.renderMs = render(signal, state, order, output, options);
+
+        auto peak = 0.f;
+
+        for (int ch = 0; ch < output.getNumChannels(); ++ch)
+        {
+            auto* out = output.getReadPointer(ch);
+            auto* ref = reference.getReadPointer(ch);
+
+            for (int i = 0; i < output.getNumSamples(); ++i)
+                peak = juce::jmax(peak, std::abs(out[i] - ref[i]));
+        }
+
+        timing.peakDiffDb = toDb(peak);
+        timings.push_back(timing);
+    }
+
+    return timings;
+}
+
+juce::String formatTileTable(const std::vector<TileTiming>& timings)
+{
+    juce::String table;
+    table << "host block " << tileBenchmarkBlockSize << ", offline" << juce::newLine
+          << juce::String("tile").paddedRight(' ', 10)
+          << juce::String("ms").paddedLeft(' ', 10)
+          << juce::String("speedup").paddedLeft(' ', 10)
+          << juce::String("diff dB").paddedLeft(' ', 10) << juce::newLine;
+
+    auto untiledMs = timings.empty() ? 0.0 : timings.front().renderMs;
+
+    for (const auto& t : timings)
+    {
+        table << (t.tileSize == 0 ? juce::String("untiled") : juce::String(t.tileSize)).paddedRight(' ', 10)
+              << juce::String(t.renderMs, 2).paddedLeft(' ', 10)
+              << (juce::String(t.renderMs > 0.0 ? untiledMs / t.renderMs : 0.0, 2) + "x").paddedLeft(' ', 10)
+              << juce::String(t.peakDiffDb, 1).paddedLeft(' ', 10) << juce::newLine;
+    }
+
+    return table;
+}
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+struct GoldenRenderTests : juce::UnitTest
+{
+    GoldenRenderTests() : juce::UnitTest("Golden output", "Project13") {}
+
+    void runTest() override
+    {
+        auto record = GoldenRender::isRecording();
+        std::vector<GoldenRender::Result> results;
+
+        if (GoldenRender::getGoldenDirectory() == juce::File())
+        {
+            beginTest("golden directory");
+            //recording has nowhere to go; a plain run just has nothing to compare against
+            expect(! record, "--record-golden needs --golden-dir");
+            logMessage("no golden directory given (--golden-dir or $PROJECT13_GOLDEN_DIR), golden comparison skipped");
+            return;
+        }
+
+        for (const auto& signal : GoldenRender::getSignals())
+        {
+            for (const auto& state : GoldenRender::getStates())
+            {
+                for (const auto& order : GoldenRender::getOrders())
+                {
+                    auto result = GoldenRender::check(signal, state, order, record);
+                    beginTest(result.caseName);
+                    expect(result.passed, result.message);
+                    results.push_back(result);
+                }
+            }
+        }
+
+        logMessage(GoldenRender::formatTable(results));
+    }
+};
+
+static GoldenRenderTests goldenRenderTests;
+
+struct TileSizeBenchmark : juce::UnitTest
+{
+    TileSizeBenchmark() : juce::UnitTest("Tile size benchmark", "Project13") {}
+
+    void runTest() override
+    {
+        auto signals = GoldenRender::getSignals();
+        auto states = GoldenRender::getStates();
+        auto orders = GoldenRender::getOrders();
+
+        auto allStages = std::find_if(states.begin(), states.end(), [](const auto& s) { return s.name == "allStages"; });
+        jassert(allStages != states.end());
+
+        beginTest("tiled renders match the untiled render");
+        auto timings = GoldenRender::benchmarkTileSizes(signals.front(), *allStages, orders.front(), GoldenRender::getTileSizes());
+
+        for (const auto& t : timings)
+            expect(t.peakDiffDb <= GoldenRender::maxPeakErrorDb,
+                   "tile " + juce::String(t.tileSize) + " differs by " + juce::String(t.peakDiffDb, 1) + " dBFS");
+
+        logMessage(GoldenRender::formatTileTable(timings));
+    }
+};
+
+static TileSizeBenchmark tileSizeBenchmark;
+
+/*
+    The mono fast path must sound exactly like running both sides: with the
+    sides going identical, different and identical again, each render with
+    it on is compared against the same render with it off, which leaves no
+    room for a step where the path switches.
+*/
+struct MonoPathTransitions : juce::UnitTest
+{
+    MonoPathTransitions() : juce::UnitTest("Mono fast path transitions", "Project13") {}
+
+    //a third of the way through and two thirds, neither on a block boundary
+    static constexpr int firstSwitch = GoldenRender::lengthSamples / 3;
+    static constexpr int secondSwitch = 2 * GoldenRender::lengthSamples / 3;
+    /** an exact state copy leaves only what is below the tolerance the right side has to settle within */
+    static constexpr float maxDiffDb = -100.f;
+
+    static GoldenRender::State makeState(float topology, bool everyStage, float monoPath)
+    {
+        return { "", [topology, everyStage, monoPath](Project13_NewAudioProcessor& p)
+            {
+                auto& cp = p.chainParams[0];
+
+                for (auto* bypass : { cp.phaserBypass, cp.chorusBypass, cp.overdriveBypass, cp.ladderFilterBypass })
+                    GoldenRender::setPlain(bypass, everyStage ? 0.f : 1.f);
+
+                //these two end the left-only run, so they stay out of the way of the stages being checked
+                GoldenRender::setPlain(cp.delayBypass, 1.f);
+                GoldenRender::setPlain(cp.convolutionBypass, 1.f);
+
+                //rings for many blocks, so the sides' states still differ well after their input matches again,
+                //but settles within the last third, so the path switches back on and its first copy is checked too
+                GoldenRender::setPlain(cp.generalFilterMode, 0.f);
+                GoldenRender::setPlain(cp.generalilterFreqHz, 100.f);
+                GoldenRender::setPlain(cp.generalilterQuality, 4.f);
+                GoldenRender::setPlain(cp.generalilterGain, 12.f);
+                GoldenRender::setPlain(cp.generalFilterTopology, topology);
+                GoldenRender::setPlain(p.monoPath, monoPath);
+            } };
+    }
+
+    void runTest() override
+    {
+        GoldenRender::Signal signal { "identicalDifferentIdentical", [](juce::AudioBuffer<float>& b)
+            {
+                juce::Random r(1234);
+
+                for (int i = 0; i < b.getNumSamples(); ++i)
+                {
+                    auto s = (r.nextFloat() * 2.f - 1.f) * 0.25f;
+                    b.setSample(0, i, s);
+                    b.setSample(1, i, i >= firstSwitch && i < secondSwitch ? (r.nextFloat() * 2.f - 1.f) * 0.25f : s);
+                }
+            } };
+
+        auto order = GoldenRender::getOrders().front();
+
+        struct Case { const char* name; float topology; bool everyStage; };
+
+        for (auto [name, topology, everyStage] : { Case { "biquad", 0.f, false }, Case { "svf", 1.f, false },
+                                                   Case { "phaser to general filter", 0.f, true } })
+        {
+            beginTest(juce::String(name) + ", auto against off");
+
+            juce::AudioBuffer<float> off, automatic;
+            GoldenRender::render(signal, makeState(topology, everyStage, 0.f), order, off);
+            GoldenRender::render(signal, makeState(topology, everyStage, 1.f), order, automatic);
+
+            auto peak = 0.f;
+            auto peakAt = 0;
+
+            for (int ch = 0; ch < GoldenRender::numChannels; ++ch)
+            {
+                for (int i = 0; i < GoldenRender::lengthSamples; ++i)
+                {
+                    if (auto diff = std::abs(automatic.getSample(ch, i) - off.getSample(ch, i)); diff > peak)
+                    {
+                        peak = diff;
+                        peakAt = i;
+                    }
+                }
+            }
+
+            auto peakDb = GoldenRender::toDb(peak);
+            expect(peakDb <= maxDiffDb, "differs by " + juce::String(peakDb, 1) + " dBFS at sample " + juce::String(peakAt)
+                                        + ", the sides switch at " + juce::String(firstSwitch) + " and " + juce::String(secondSwitch));
+        }
+    }
+};
+
+static MonoPathTransitions monoPathTransitions;
+
+#endif
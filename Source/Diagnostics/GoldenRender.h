@@ -0,0 +1,134 @@
+/*
+  ==============================================================================
+
+    GoldenRender.h
+    Renders fixed signals through fixed states and checks them against
+    recorded golden output, reporting render times alongside.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../PluginProcessor.h"
+
+/**
+    Every case is one deterministic input signal, one parameter state and one
+    DSP_Order (applied to every band). Golden output is stored as 32-bit float
+    WAV next to a small JSON file holding the render time it was recorded with.
+
+    The golden set is recorded into, and committed from, Tests/Golden. The
+    runner is told where that is with --golden-dir=<dir> (or
+    $PROJECT13_GOLDEN_DIR), since neither the working directory nor the
+    compiler's __FILE__ says anything reliable about where the checkout
+    is. With no directory given
+    the comparison is skipped and says so; with one, a case without a
+    readable golden file fails. Only when recording, with --record-golden or
+    $PROJECT13_UPDATE_GOLDEN=1, is the current render written out instead of
+    compared.
+
+    Render times are only reported next to the recorded ones, never gated on:
+    the recorded time comes from whichever machine made the golden set.
+
+    The checks are registered as a juce::UnitTest and run by the
+    Project13_Tests console app (Tests/Project13_Tests.jucer), which defines
+    JUCE_UNIT_TESTS. None of this is built into the plugin.
+*/
+namespace GoldenRender
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int blockSize = 512;
+    constexpr int numChannels = 2;
+    constexpr int lengthSamples = 48000;
+
+    /** fail when the output differs by more than this, relative to full scale */
+    constexpr float maxPeakErrorDb = -80.f;
+    /** best-of-N timing to keep scheduler noise out of the reported times */
+    constexpr int timingRepeats = 3;
+
+    struct Signal
+    {
+        juce::String name;
+        std::function<void(juce::AudioBuffer<float>&)> generate;
+    };
+
+    struct State
+    {
+        juce::String name;
+        std::function<void(Project13_NewAudioProcessor&)> apply;
+    };
+
+    struct Order
+    {
+        juce::String name;
+        Project13_NewAudioProcessor::DSP_Order order;
+    };
+
+    struct Result
+    {
+        juce::String caseName;
+        bool recorded = false;
+        bool passed = true;
+        float peakErrorDb = -200.f;
+        float rmsErrorDb = -200.f;
+        double renderMs = 0.0;
+        double goldenMs = 0.0;
+        juce::String message;
+    };
+
+    std::vector<Signal> getSignals();
+    std::vector<State> getStates();
+    std::vector<Order> getOrders();
+
+    /** the directory set by the runner, else $PROJECT13_GOLDEN_DIR; a default File when neither is given */
+    juce::File getGoldenDirectory();
+    /** set by the test runner from --golden-dir */
+    void setGoldenDirectory(const juce::File& directory);
+
+    /** true after setRecording(true) or with $PROJECT13_UPDATE_GOLDEN=1 */
+    bool isRecording();
+    /** set by the test runner from --record-golden */
+    void setRecording(bool shouldRecord);
+
+    struct RenderOptions
+    {
+        int hostBlockSize = blockSize;
+        int tileSize = Project13_NewAudioProcessor::defaultTileSize;
+        /** render as an offline bounce would */
+        bool nonRealtime = false;
+    };
+
+    /** renders one case on a fresh processor; returns the best time of timingRepeats runs in ms */
+    double render(const Signal& signal, const State& state, const Order& order, juce::AudioBuffer<float>& output,
+                  const RenderOptions& options = {});
+
+    /** renders, then compares against the golden files for this case, or records them */
+    Result check(const Signal& signal, const State& state, const Order& order, bool record);
+
+    /** runs every case and returns one line per case, formatted as a table */
+    std::vector<Result> checkAll(bool record);
+    juce::String formatTable(const std::vector<Result>& results);
+
+    //==============================================================================
+    /*
+        Tile size benchmark: renders with the long blocks of an offline bounce
+        at each tile size and compares every render against the untiled one,
+        which tiling must not change. The sizes come from $PROJECT13_TILE_SIZES
+        (comma separated) when it is set, so a CPU can be tuned without a rebuild.
+    */
+    constexpr int tileBenchmarkBlockSize = 8192;
+
+    struct TileTiming
+    {
+        int tileSize = 0;
+        double renderMs = 0.0;
+        float peakDiffDb = -200.f;
+    };
+
+    std::vector<int> getTileSizes();
+    /** the untiled render always comes first, as the reference */
+    std::vector<TileTiming> benchmarkTileSizes(const Signal& signal, const State& state, const Order& order,
+                                               const std::vector<int>& tileSizes);
+    juce::String formatTileTable(const std::vector<TileTiming>& timings);
+}
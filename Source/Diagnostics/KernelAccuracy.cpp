@@ -0,0 +1,504 @@
+/*
+  ==============================================================================
+
+    KernelAccuracy.cpp
+
+  ==============================================================================
+*/
+
+#include "KernelAccuracy.h"
+
+namespace KernelAccuracy
+{
+namespace
+{
+using Mode = TptSvf::Mode;
+using Coefficients = juce::dsp::IIR::Coefficients<float>;
+using FilterDuplicator = juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, Coefficients>;
+
+juce::String getModeName(Mode mode)
+{
+    switch (mode)
+    {
+        case Mode::Peak: return "peak";
+        case Mode::BandPass: return "bandpass";
+        case Mode::Notch: return "notch";
+        case Mode::AllPass: return "allpass";
+    }
+
+    return {};
+}
+
+/** the exact RBJ coefficients, worked out in full by JUCE */
+std::array<float, 6> makeReferenceCoefficients(Mode mode, float freqHz, float q, float gainDb)
+{
+    using ArrayCoefficients = juce::dsp::IIR::ArrayCoefficients<float>;
+
+    switch (mode)
+    {
+        case Mode::Peak: return ArrayCoefficients::makePeakFilter(sampleRate, freqHz, q, juce::Decibels::decibelsToGain(gainDb));
+        case Mode::BandPass: return ArrayCoefficients::makeBandPass(sampleRate, freqHz, q);
+        case Mode::Notch: return ArrayCoefficients::makeNotch(sampleRate, freqHz, q);
+        case Mode::AllPass: return ArrayCoefficients::makeAllPass(sampleRate, freqHz, q);
+    }
+
+    return {{ 1.f, 0.f, 0.f, 1.f, 0.f, 0.f }};
+}
+
+juce::dsp::ProcessSpec getSpec()
+{
+    return { sampleRate, static_cast<juce::uint32>(GoldenRender::blockSize), static_cast<juce::uint32>(numChannels) };
+}
+
+float toDb(float gain)
+{
+    return juce::Decibels::gainToDecibels(gain, -200.f);
+}
+
+template <typename Fn>
+void forEachSubBlock(juce::dsp::AudioBlock<float>& block, int subBlockSize, Fn&& fn)
+{
+    auto numSamples = block.getNumSamples();
+
+    for (size_t start = 0; start < numSamples; start += static_cast<size_t>(subBlockSize))
+    {
+        auto subBlock = block.getSubBlock(start, juce::jmin(static_cast<size_t>(subBlockSize), numSamples - start));
+        fn(subBlock, start);
+    }
+}
+
+/** processFresh builds its own state, so construction is timed too; it is tiny next to a second of audio */
+double renderBest(const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output,
+                  const std::function<void(juce::dsp::AudioBlock<float>&)>& processFresh)
+{
+    auto best = std::numeric_limits<double>::max();
+
+    for (int run = 0; run < GoldenRender::timingRepeats; ++run)
+    {
+        output.makeCopyOf(input);
+        juce::dsp::AudioBlock<float> block(output);
+
+        auto start = juce::Time::getHighResolutionTicks();
+        processFresh(block);
+        auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - start);
+        best = juce::jmin(best, elapsed * 1000.0);
+    }
+
+    return best;
+}
+
+//==============================================================================
+/** JUCE's IIR filter with fixed coefficients */
+Render renderReferenceFilter(Mode mode, float freqHz, float q, float gainDb)
+{
+    return [=](const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output)
+    {
+        return renderBest(input, output, [=](juce::dsp::AudioBlock<float>& block)
+        {
+            FilterDuplicator filter;
+            filter.state = new Coefficients(makeReferenceCoefficients(mode, freqHz, q, gainDb));
+            filter.prepare(getSpec());
+
+            forEachSubBlock(block, GoldenRender::blockSize, [&filter](juce::dsp::AudioBlock<float>& subBlock, size_t)
+            {
+                filter.process(juce::dsp::ProcessContextReplacing<float>(subBlock));
+            });
+        });
+    };
+}
+
+/** the general filter's SVF topology with the same fixed settings */
+Render renderSvf(Mode mode, float freqHz, float q, float gainDb)
+{
+    return [=](const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output)
+    {
+        return renderBest(input, output, [=](juce::dsp::AudioBlock<float>& block)
+        {
+            TptSvf svf;
+            svf.prepare(getSpec());
+            svf.setParameters(mode, freqHz, q, gainDb);
+
+            forEachSubBlock(block, GoldenRender::blockSize, [&svf](juce::dsp::AudioBlock<float>& subBlock, size_t)
+            {
+                svf.process(juce::dsp::ProcessContextReplacing<float>(subBlock));
+            });
+        });
+    };
+}
+
+/** a notch swept from 200 Hz to 8 kHz over the render, as an automated cutoff would be */
+Render renderSvfSweep(int controlInterval)
+{
+    return [=](const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output)
+    {
+        return renderBest(input, output, [=](juce::dsp::AudioBlock<float>& block)
+        {
+            TptSvf svf;
+            svf.prepare(getSpec());
+            svf.setControlInterval(controlInterval);
+
+            forEachSubBlock(block, controlBlockSize, [&svf](juce::dsp::AudioBlock<float>& subBlock, size_t start)
+            {
+                auto position = static_cast<double>(start) / lengthSamples;
+                svf.setParameters(Mode::Notch, static_cast<float>(200.0 * std::pow(40.0, position)), 4.f, 0.f);
+                svf.process(juce::dsp::ProcessContextReplacing<float>(subBlock));
+            });
+        });
+    };
+}
+
+/**
+    A JUCE processor, or the chain's own stage that stands in for it, with
+    the same settings from fresh. configure takes either, since the chain's
+    stages keep JUCE's setter names.
+*/
+template <typename Processor, typename Configure>
+Render renderStage(Configure configure)
+{
+    return [=](const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output)
+    {
+        return renderBest(input, output, [=](juce::dsp::AudioBlock<float>& block)
+        {
+            Processor processor;
+            configure(processor);
+            processor.prepare(getSpec());
+            processor.reset();
+
+            forEachSubBlock(block, GoldenRender::blockSize, [&processor](juce::dsp::AudioBlock<float>& subBlock, size_t)
+            {
+                processor.process(juce::dsp::ProcessContextReplacing<float>(subBlock));
+            });
+        });
+    };
+}
+
+/** the general filter's biquad topology with fixed settings */
+Render renderStereoBiquad(Mode mode, float freqHz, float q, float gainDb)
+{
+    return renderStage<StereoBiquad>([=](StereoBiquad& filter)
+    {
+        filter.setCoefficients(makeReferenceCoefficients(mode, freqHz, q, gainDb));
+    });
+}
+
+/** the whole processor */
+Render renderProcessor(const GoldenRender::State& state, const GoldenRender::RenderOptions& options)
+{
+    return [=](const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output)
+    {
+        GoldenRender::Signal signal { "input", [&input](juce::AudioBuffer<float>& b) { b.makeCopyOf(input); } };
+        return GoldenRender::render(signal, state, GoldenRender::getOrders().front(), output, options);
+    };
+}
+
+GoldenRender::State withMonoPath(const GoldenRender::State& state, int monoPathIndex)
+{
+    return { state.name, [state, monoPathIndex](Project13_NewAudioProcessor& p)
+    {
+        state.apply(p);
+        p.monoPath->setValueNotifyingHost(p.monoPath->convertTo0to1(static_cast<float>(monoPathIndex)));
+    } };
+}
+
+//==============================================================================
+/**
+    The same noise on both channels, so the mono fast path has something to
+    find. With sidesPart, the right channel has its own noise through the
+    middle third, so the path switches off and back on mid-block.
+*/
+void generateNoise(juce::AudioBuffer<float>& b, bool sidesPart)
+{
+    b.setSize(numChannels, lengthSamples);
+    juce::Random r(1234);
+
+    for (int i = 0; i < lengthSamples; ++i)
+    {
+        auto s = (r.nextFloat() * 2.f - 1.f) * 0.25f;
+        b.setSample(0, i, s);
+
+        if (sidesPart && i >= lengthSamples / 3 && i < 2 * lengthSamples / 3)
+            s = (r.nextFloat() * 2.f - 1.f) * 0.25f;
+
+        for (int ch = 1; ch < numChannels; ++ch)
+            b.setSample(ch, i, s);
+    }
+}
+
+void generateSine(juce::AudioBuffer<float>& b)
+{
+    b.setSize(numChannels, lengthSamples);
+
+    for (int i = 0; i < lengthSamples; ++i)
+    {
+        auto s = static_cast<float>(0.5 * std::sin(juce::MathConstants<double>::twoPi * thdFundamentalHz * i / sampleRate));
+
+        for (int ch = 0; ch < numChannels; ++ch)
+            b.setSample(ch, i, s);
+    }
+}
+
+/** harmonics over fundamental, as a ratio, from the second half of the first channel once any transient has died away */
+double getThd(const juce::AudioBuffer<float>& b)
+{
+    auto* x = b.getReadPointer(0);
+    auto start = b.getNumSamples() / 2;
+    auto n = b.getNumSamples() - start;
+
+    auto magnitudeAt = [x, start, n](double freqHz)
+    {
+        auto w = juce::MathConstants<double>::twoPi * freqHz / sampleRate;
+        double re = 0.0, im = 0.0;
+
+        for (int i = 0; i < n; ++i)
+        {
+            re += x[start + i] * std::cos(w * i);
+            im -= x[start + i] * std::sin(w * i);
+        }
+
+        return 2.0 * std::sqrt(re * re + im * im) / n;
+    };
+
+    auto fundamental = magnitudeAt(thdFundamentalHz);
+
+    //a filter that removes the fundamental leaves nothing to measure against
+    if (fundamental < 1.0e-6)
+        return 0.0;
+
+    auto sumSquares = 0.0;
+
+    for (int h = 2; h <= numHarmonics + 1; ++h)
+        sumSquares += juce::square(magnitudeAt(thdFundamentalHz * h));
+
+    return std::sqrt(sumSquares) / fundamental;
+}
+}
+
+//==============================================================================
+std::vector<Kernel> getKernels()
+{
+    std::vector<Kernel> kernels;
+
+    const auto modes = { Mode::Peak, Mode::BandPass, Mode::Notch, Mode::AllPass };
+    const auto qualities = { 0.7f, 4.f };
+
+    //same transfer function by a different structure, so only rounding separates them
+    for (auto mode : modes)
+        for (auto freqHz : { 100.f, 1000.f, 8000.f })
+            for (auto q : qualities)
+                kernels.push_back({ "svf " + getModeName(mode) + " " + juce::String(freqHz) + " Hz q " + juce::String(q),
+                                    renderReferenceFilter(mode, freqHz, q, 12.f),
+                                    renderSvf(mode, freqHz, q, 12.f),
+                                    transparent });
+
+    //the control intervals of the quality levels, against a tan every sample
+    for (auto interval : { 8, 32, 64 })
+        kernels.push_back({ "svf sweep, tan every " + juce::String(interval),
+                            renderSvfSweep(1),
+                            renderSvfSweep(interval),
+                            degraded });
+
+    //the chain's stereo stages run JUCE's algorithms, so only rounding separates them
+    for (auto mode : modes)
+        kernels.push_back({ "biquad " + getModeName(mode),
+                            renderReferenceFilter(mode, 1000.f, 4.f, 12.f),
+                            renderStereoBiquad(mode, 1000.f, 4.f, 12.f),
+                            transparent });
+
+    auto configurePhaser = [](auto& phaser)
+    {
+        phaser.setRate(0.7f);
+        phaser.setDepth(0.8f);
+        phaser.setCentreFrequency(900.f);
+        phaser.setFeedback(0.6f);
+        phaser.setMix(0.5f);
+    };
+
+    kernels.push_back({ "phaser",
+                        renderStage<juce::dsp::Phaser<float>>(configurePhaser),
+                        renderStage<StereoPhaser>(configurePhaser),
+                        transparent });
+
+    auto configureChorus = [](auto& chorus)
+    {
+        chorus.setRate(1.3f);
+        chorus.setDepth(0.6f);
+        chorus.setCentreDelay(12.f);
+        chorus.setFeedback(0.4f);
+        chorus.setMix(0.5f);
+    };
+
+    kernels.push_back({ "chorus",
+                        renderStage<juce::dsp::Chorus<float>>(configureChorus),
+                        renderStage<StereoChorus>(configureChorus),
+                        transparent });
+
+    //the LFO at the quality levels' control intervals, against JUCE's every sample
+    for (auto interval : { 8, 32 })
+        kernels.push_back({ "chorus, LFO every " + juce::String(interval),
+                            renderStage<juce::dsp::Chorus<float>>(configureChorus),
+                            renderStage<StereoChorus>([=](StereoChorus& chorus)
+                            {
+                                configureChorus(chorus);
+                                chorus.setControlInterval(interval);
+                            }),
+                            degraded });
+
+    for (auto ladderMode : { juce::dsp::LadderFilterMode::LPF24, juce::dsp::LadderFilterMode::HPF12, juce::dsp::LadderFilterMode::BPF24 })
+    {
+        auto configureLadder = [ladderMode](auto& ladder)
+        {
+            ladder.setMode(ladderMode);
+            ladder.setCutoffFrequencyHz(1200.f);
+            ladder.setResonance(0.7f);
+            ladder.setDrive(4.f);
+        };
+
+        kernels.push_back({ "ladder mode " + juce::String(static_cast<int>(ladderMode)),
+                            renderStage<juce::dsp::LadderFilter<float>>(configureLadder),
+                            renderStage<StereoLadder>(configureLadder),
+                            transparent });
+    }
+
+    //none of these should change the output at all
+    auto states = GoldenRender::getStates();
+    auto findState = [&states](const juce::String& name)
+    {
+        auto state = std::find_if(states.begin(), states.end(), [&name](const auto& s) { return s.name == name; });
+        jassert(state != states.end());
+        return *state;
+    };
+
+    auto allStages = findState("allStages");
+    auto svf = findState("generalFilterSvf");
+
+    kernels.push_back({ "chain, mono fast path",
+                        renderProcessor(withMonoPath(allStages, 0), {}),
+                        renderProcessor(withMonoPath(allStages, 1), {}),
+                        transparent });
+
+    //the right side goes stale and is copied back both ways across the middle third
+    kernels.push_back({ "chain, mono fast path, sides part",
+                        renderProcessor(withMonoPath(svf, 0), {}),
+                        renderProcessor(withMonoPath(svf, 1), {}),
+                        transparent,
+                        true });
+
+    GoldenRender::RenderOptions untiled, tiled;
+    untiled.hostBlockSize = tiled.hostBlockSize = GoldenRender::tileBenchmarkBlockSize;
+    untiled.nonRealtime = tiled.nonRealtime = true;
+    untiled.tileSize = 0;
+
+    kernels.push_back({ "chain, tiled " + juce::String(tiled.tileSize),
+                        renderProcessor(allStages, untiled),
+                        renderProcessor(allStages, tiled),
+                        transparent });
+
+    return kernels;
+}
+
+Result check(const Kernel& kernel)
+{
+    Result result;
+    result.name = kernel.name;
+
+    juce::AudioBuffer<float> noise, sine, reference, fast;
+    generateNoise(noise, kernel.sidesPart);
+    generateSine(sine);
+
+    result.referenceMs = kernel.reference(noise, reference);
+    result.fastMs = kernel.fast(noise, fast);
+
+    auto peak = 0.f;
+    auto errorSquares = 0.0, referenceSquares = 0.0;
+
+    for (int ch = 0; ch < reference.getNumChannels(); ++ch)
+    {
+        auto* ref = reference.getReadPointer(ch);
+        auto* out = fast.getReadPointer(ch);
+
+        for (int i = 0; i < reference.getNumSamples(); ++i)
+        {
+            auto diff = out[i] - ref[i];
+            peak = juce::jmax(peak, std::abs(diff));
+            errorSquares += static_cast<double>(diff) * diff;
+            referenceSquares += static_cast<double>(ref[i]) * ref[i];
+        }
+    }
+
+    result.maxErrorDb = toDb(peak);
+
+    if (errorSquares > 0.0)
+        result.snrDb = juce::jmin(200.f, static_cast<float>(10.0 * std::log10(referenceSquares / errorSquares)));
+
+    kernel.reference(sine, reference);
+    kernel.fast(sine, fast);
+    result.thdDiffDb = toDb(static_cast<float>(std::abs(getThd(fast) - getThd(reference))));
+
+    const auto& bounds = kernel.bounds;
+
+    if (result.maxErrorDb > bounds.maxErrorDb)
+        result.message << "peak error " << juce::String(result.maxErrorDb, 1) << " dBFS over " << juce::String(bounds.maxErrorDb, 1) << ". ";
+    if (result.snrDb < bounds.minSnrDb)
+        result.message << "SNR " << juce::String(result.snrDb, 1) << " dB under " << juce::String(bounds.minSnrDb, 1) << ". ";
+    if (result.thdDiffDb > bounds.maxThdDiffDb)
+        result.message << "THD differs by " << juce::String(result.thdDiffDb, 1) << " dB, over " << juce::String(bounds.maxThdDiffDb, 1) << ".";
+
+    result.passed = result.message.isEmpty();
+    return result;
+}
+
+juce::String formatTable(const std::vector<Result>& results)
+{
+    juce::String table;
+    table << juce::String("kernel").paddedRight(' ', 38)
+          << juce::String("max dB").paddedLeft(' ', 9)
+          << juce::String("SNR dB").paddedLeft(' ', 9)
+          << juce::String("THD dB").paddedLeft(' ', 9)
+          << juce::String("ref ms").paddedLeft(' ', 9)
+          << juce::String("fast ms").paddedLeft(' ', 9)
+          << juce::String("speedup").paddedLeft(' ', 9)
+          << "  result" << juce::newLine;
+
+    for (const auto& r : results)
+    {
+        table << r.name.paddedRight(' ', 38)
+              << juce::String(r.maxErrorDb, 1).paddedLeft(' ', 9)
+              << juce::String(r.snrDb, 1).paddedLeft(' ', 9)
+              << juce::String(r.thdDiffDb, 1).paddedLeft(' ', 9)
+              << juce::String(r.referenceMs, 2).paddedLeft(' ', 9)
+              << juce::String(r.fastMs, 2).paddedLeft(' ', 9)
+              << (juce::String(r.getSpeedup(), 2) + "x").paddedLeft(' ', 9)
+              << "  " << (r.passed ? "ok" : "FAIL " + r.message)
+              << juce::newLine;
+    }
+
+    return table;
+}
+}
+
+//==============================================================================
+#if JUCE_UNIT_TESTS
+
+struct KernelAccuracyTests : juce::UnitTest
+{
+    KernelAccuracyTests() : juce::UnitTest("Kernel accuracy", "Project13") {}
+
+    void runTest() override
+    {
+        std::vector<KernelAccuracy::Result> results;
+
+        for (const auto& kernel : KernelAccuracy::getKernels())
+        {
+            beginTest(kernel.name);
+            auto result = KernelAccuracy::check(kernel);
+            expect(result.passed, result.message);
+            results.push_back(result);
+        }
+
+        logMessage(KernelAccuracy::formatTable(results));
+    }
+};
+
+static KernelAccuracyTests kernelAccuracyTests;
+
+#endif
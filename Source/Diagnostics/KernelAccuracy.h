@@ -0,0 +1,108 @@
+/*
+  ==============================================================================
+
+    KernelAccuracy.h
+    Runs each fast kernel beside the JUCE processor it stands in for and
+    checks how far apart they are and how much faster the fast one is.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "GoldenRender.h"
+#include "../DSP/TptSvf.h"
+#include "../DSP/StereoPhaser.h"
+#include "../DSP/StereoChorus.h"
+#include "../DSP/StereoLadder.h"
+#include "../DSP/StereoBiquad.h"
+
+/**
+    Every kernel is a pair of renders over the same input: the reference,
+    either a juce::dsp processor (IIR::Filter, Phaser, Chorus or
+    LadderFilter) or the whole chain the way it ran before, and the fast or
+    stand-in version. Each pair is
+    rendered with noise to measure the peak error, the SNR and the speed,
+    and with a sine to compare the harmonic distortion.
+
+    Every kernel is held to one of two bounds, set by what can be heard
+    rather than by what the kernels happen to produce. Speedup is reported
+    but never fails a check, since it depends on the machine.
+
+    The checks are registered as a juce::UnitTest and run by the
+    Project13_Tests console app, like GoldenRender. None of this is built
+    into the plugin.
+*/
+namespace KernelAccuracy
+{
+    constexpr double sampleRate = GoldenRender::sampleRate;
+    constexpr int lengthSamples = GoldenRender::lengthSamples;
+    constexpr int numChannels = GoldenRender::numChannels;
+
+    /** a whole number of periods fits the analysed half, so no window is needed */
+    constexpr double thdFundamentalHz = 750.0;
+    constexpr int numHarmonics = 8;
+
+    /** how often the control-rate kernels get new settings, the same as the morph sub-block */
+    constexpr int controlBlockSize = 32;
+
+    struct Bounds
+    {
+        /** peak difference, dBFS */
+        float maxErrorDb = -80.f;
+        /** reference power over difference power, dB */
+        float minSnrDb = 60.f;
+        /** difference between the two THD ratios, dB */
+        float maxThdDiffDb = -60.f;
+    };
+
+    /**
+        For kernels that must not change the sound: the golden check's own
+        peak limit, which is below 16-bit dither. The noise input peaks at
+        -12 dBFS, so the error's power is held the same 68 dB under the
+        signal's, and the THD, which is inaudible well above -70 dB, to
+        within that.
+    */
+    constexpr Bounds transparent { GoldenRender::maxPeakErrorDb, 68.f, -70.f };
+
+    /**
+        For the cheaper settings the quality governor falls back to under CPU
+        pressure: 60 dB under the signal and -60 dBFS at worst, which is below
+        the noise floor of a mix, and only while a setting is moving.
+    */
+    constexpr Bounds degraded { -60.f, 60.f, -60.f };
+
+    /** renders input into output from fresh state; returns the best processing time of GoldenRender::timingRepeats runs in ms */
+    using Render = std::function<double(const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output)>;
+
+    struct Kernel
+    {
+        juce::String name;
+        Render reference, fast;
+        Bounds bounds;
+        /** the noise goes identical, different, then identical again across the channels, rather than staying identical */
+        bool sidesPart = false;
+    };
+
+    struct Result
+    {
+        juce::String name;
+        bool passed = true;
+        float maxErrorDb = -200.f;
+        float snrDb = 200.f;
+        float thdDiffDb = -200.f;
+        double referenceMs = 0.0;
+        double fastMs = 0.0;
+        juce::String message;
+
+        double getSpeedup() const { return fastMs > 0.0 ? referenceMs / fastMs : 0.0; }
+    };
+
+    std::vector<Kernel> getKernels();
+
+    /** renders both sides of one kernel and compares them against its bounds */
+    Result check(const Kernel& kernel);
+
+    juce::String formatTable(const std::vector<Result>& results);
+}
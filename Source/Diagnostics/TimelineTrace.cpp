@@ -0,0 +1,159 @@
+/*
+  ==============================================================================
+
+    TimelineTrace.cpp
+
+  ==============================================================================
+*/
+
+#include "TimelineTrace.h"
+
+std::atomic<TimelineTrace*> TimelineTrace::instance { nullptr };
+
+TimelineTrace::TimelineTrace()
+{
+    instance.store(this, std::memory_order_release);
+
+    auto path = juce::SystemStats::getEnvironmentVariable("PROJECT13_TRACE_FILE", {});
+
+    if (path.isNotEmpty() && juce::File::isAbsolutePath(path))
+        start(juce::File(path));
+}
+
+TimelineTrace::~TimelineTrace()
+{
+    //every processor holds a pointer to this, so no trace point can still be running
+    instance.store(nullptr, std::memory_order_release);
+    stop();
+}
+
+bool TimelineTrace::start(const juce::File& file)
+{
+    stop();
+
+    file.deleteFile();
+    output = std::make_unique<juce::FileOutputStream>(file);
+
+    if (output->failedToOpen())
+    {
+        output.reset();
+        return false;
+    }
+
+    if (ring == nullptr)
+        ring = std::make_unique<Event[]>(static_cast<size_t>(ringSize));
+
+    //anything still in the ring belongs to an earlier capture
+    readIndex.store(writeIndex.load(std::memory_order_acquire), std::memory_order_release);
+    dropped.store(0);
+    threads.clear();
+    firstEvent = true;
+    startTicks = juce::Time::getHighResolutionTicks();
+
+    *output << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+
+    capturing.store(true, std::memory_order_release);
+    writer.startThread(juce::Thread::Priority::low);
+    return true;
+}
+
+void TimelineTrace::stop()
+{
+    if (output == nullptr)
+        return;
+
+    capturing.store(false, std::memory_order_release);
+    writer.stopThread(2000);
+    drain();
+
+    *output << "\n]}\n";
+    output->flush();
+    output.reset();
+}
+
+//==============================================================================
+void TimelineTrace::record(const char* name, Phase phase) noexcept
+{
+    auto* trace = instance.load(std::memory_order_acquire);
+
+    if (trace != nullptr && trace->capturing.load(std::memory_order_relaxed))
+        trace->push(name, phase);
+}
+
+void TimelineTrace::push(const char* name, Phase phase) noexcept
+{
+    auto ticks = juce::Time::getHighResolutionTicks();
+    auto index = writeIndex.load(std::memory_order_relaxed);
+
+    //claim the next slot, unless the writer has not emptied it yet
+    do
+    {
+        if (index - readIndex.load(std::memory_order_acquire) >= static_cast<juce::uint64>(ringSize))
+        {
+            dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    while (! writeIndex.compare_exchange_weak(index, index + 1, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+    auto& event = ring[static_cast<size_t>(index & (ringSize - 1))];
+    event.ticks = ticks;
+    event.name = name;
+    event.thread = juce::Thread::getCurrentThreadId();
+    event.phase = phase;
+    event.sequence.store(index + 1, std::memory_order_release);
+}
+
+//==============================================================================
+int TimelineTrace::getThreadIndex(juce::Thread::ThreadID thread)
+{
+    auto found = std::find(threads.begin(), threads.end(), thread);
+
+    if (found != threads.end())
+        return static_cast<int>(std::distance(threads.begin(), found)) + 1;
+
+    threads.push_back(thread);
+    auto index = static_cast<int>(threads.size());
+
+    //named by order of appearance: the host's audio thread is almost always 1
+    *output << (firstEvent ? "" : ",\n")
+            << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << index
+            << ",\"args\":{\"name\":\"Thread " << index << "\"}}";
+    firstEvent = false;
+
+    return index;
+}
+
+void TimelineTrace::drain()
+{
+    auto index = readIndex.load(std::memory_order_relaxed);
+
+    //stops at the first slot that is claimed but not yet published; the next pass picks it up
+    for (;; ++index)
+    {
+        auto& event = ring[static_cast<size_t>(index & (ringSize - 1))];
+
+        if (event.sequence.load(std::memory_order_acquire) != index + 1)
+            break;
+
+        auto tid = getThreadIndex(event.thread);
+        auto micros = juce::Time::highResolutionTicksToSeconds(event.ticks - startTicks) * 1.0e6;
+
+        *output << (firstEvent ? "" : ",\n")
+                << "{\"name\":\"" << event.name << "\",\"ph\":\"" << juce::String::charToString(static_cast<char>(event.phase))
+                << "\",\"ts\":" << juce::String(micros, 3) << ",\"pid\":1,\"tid\":" << tid
+                << (event.phase == Phase::Instant ? ",\"s\":\"t\"}" : "}");
+        firstEvent = false;
+    }
+
+    readIndex.store(index, std::memory_order_release);
+}
+
+void TimelineTrace::Writer::run()
+{
+    while (! threadShouldExit())
+    {
+        trace.drain();
+        wait(drainIntervalMs);
+    }
+}
@@ -0,0 +1,129 @@
+/*
+  ==============================================================================
+
+    TimelineTrace.h
+    Opt-in begin/end event capture, written out as Chrome trace JSON.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/*
+    Build with PROJECT13_TRACING=1 to compile the trace points in. Without it
+    every PROJECT13_TRACE_* macro expands to nothing.
+*/
+#ifndef PROJECT13_TRACING
+ #define PROJECT13_TRACING 0
+#endif
+
+/**
+    Any thread, including the audio thread and the band workers, records an
+    event by claiming the next slot of a preallocated ring with one
+    compare-and-swap and publishing it with one store. Nothing locks or
+    allocates. When the ring is full the event is dropped and counted rather
+    than waited for.
+
+    A background thread drains the ring every drainIntervalMs and appends the
+    events to a JSON file that chrome://tracing and ui.perfetto.dev open
+    directly, one track per thread, timestamps in microseconds from start().
+
+    Event names must be string literals (or otherwise outlive the capture):
+    only the pointer is recorded.
+
+    One instance is shared process-wide through juce::SharedResourcePointer.
+    Capture starts when start() is called, or as soon as the instance is made
+    when $PROJECT13_TRACE_FILE names the output file.
+*/
+class TimelineTrace
+{
+public:
+    static constexpr int ringSize = 1 << 16;
+    static constexpr int drainIntervalMs = 20;
+
+    TimelineTrace();
+    ~TimelineTrace();
+
+    /** message thread; false if the file could not be opened */
+    bool start(const juce::File& file);
+    /** message thread; writes everything still in the ring and closes the file */
+    void stop();
+    bool isCapturing() const { return capturing.load(std::memory_order_relaxed); }
+
+    /** events lost to a full ring since start() */
+    juce::int64 getNumDropped() const { return dropped.load(std::memory_order_relaxed); }
+
+    /** Chrome trace phases */
+    enum class Phase : char { Begin = 'B', End = 'E', Instant = 'i' };
+
+    /** any thread; a no-op unless an instance is capturing */
+    static void record(const char* name, Phase phase) noexcept;
+
+    /** begin on construction, end on destruction */
+    struct Scope
+    {
+        explicit Scope(const char* n) noexcept : name(n) { record(name, Phase::Begin); }
+        ~Scope() noexcept { record(name, Phase::End); }
+
+        const char* name;
+
+        JUCE_DECLARE_NON_COPYABLE(Scope)
+    };
+
+private:
+    struct Event
+    {
+        std::atomic<juce::uint64> sequence { 0 };
+        juce::int64 ticks = 0;
+        const char* name = nullptr;
+        juce::Thread::ThreadID thread = nullptr;
+        Phase phase = Phase::Instant;
+    };
+
+    struct Writer : juce::Thread
+    {
+        explicit Writer(TimelineTrace& t) : juce::Thread("Trace writer"), trace(t) {}
+        void run() override;
+        TimelineTrace& trace;
+    };
+
+    void push(const char* name, Phase phase) noexcept;
+    /** writer side: appends every published event to the file */
+    void drain();
+    int getThreadIndex(juce::Thread::ThreadID thread);
+
+    static std::atomic<TimelineTrace*> instance;
+
+    std::unique_ptr<Event[]> ring;
+    std::atomic<juce::uint64> writeIndex { 0 }, readIndex { 0 };
+    std::atomic<juce::int64> dropped { 0 };
+    std::atomic<bool> capturing { false };
+
+    //writer thread while capturing, message thread otherwise
+    std::unique_ptr<juce::FileOutputStream> output;
+    juce::int64 startTicks = 0;
+    bool firstEvent = true;
+    std::vector<juce::Thread::ThreadID> threads;
+
+    Writer writer { *this };
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (TimelineTrace)
+};
+
+#if PROJECT13_TRACING
+ #define PROJECT13_TRACE_CONCAT_(a, b) a##b
+ #define PROJECT13_TRACE_CONCAT(a, b) PROJECT13_TRACE_CONCAT_(a, b)
+ /** traces the rest of the enclosing scope */
+ #define PROJECT13_TRACE_SCOPE(name) const TimelineTrace::Scope PROJECT13_TRACE_CONCAT(traceScope_, __LINE__) { name }
+ #define PROJECT13_TRACE_BEGIN(name) TimelineTrace::record(name, TimelineTrace::Phase::Begin)
+ #define PROJECT13_TRACE_END(name) TimelineTrace::record(name, TimelineTrace::Phase::End)
+ /** a point in time, e.g. a state handoff */
+ #define PROJECT13_TRACE_INSTANT(name) TimelineTrace::record(name, TimelineTrace::Phase::Instant)
+#else
+ #define PROJECT13_TRACE_SCOPE(name)
+ #define PROJECT13_TRACE_BEGIN(name)
+ #define PROJECT13_TRACE_END(name)
+ #define PROJECT13_TRACE_INSTANT(name)
+#endif
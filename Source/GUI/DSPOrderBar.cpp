@@ -0,0 +1,226 @@
+/*
+  ==============================================================================
+
+    DSPOrderBar.cpp
+
+  ==============================================================================
+*/
+
+#include "DSPOrderBar.h"
+
+DSPOrderBar::DSPOrderBar()
+{
+    setOpaque(true);
+}
+
+DSPOrderBar::~DSPOrderBar()
+{
+    if (animating)
+        animationTimer->removeClient(this);
+}
+
+juce::String DSPOrderBar::getOptionName(DSP_Option option)
+{
+    switch (option)
+    {
+        case DSP_Option::Phase: return "Phaser";
+        case DSP_Option::Chorus: return "Chorus";
+        case DSP_Option::Overdrive: return "Overdrive";
+        case DSP_Option::LadderFilter: return "Ladder Filter";
+        case DSP_Option::GeneralFilter: return "General Filter";
+        case DSP_Option::Delay: return "Delay";
+        case DSP_Option::Convolution: return "Convolution";
+        case DSP_Option::END_OF_LIST: break;
+    }
+
+    jassertfalse;
+    return {};
+}
+
+void DSPOrderBar::setOrder(const DSP_Order& newOrder)
+{
+    if (newOrder == getOrder())
+        return;
+
+    //keep each option's on-screen position so it can glide to its new slot
+    auto previous = tabs;
+
+    for (size_t i = 0; i < tabs.size(); ++i)
+    {
+        tabs[i].option = newOrder[i];
+        tabs[i].x = getSlotX(i);
+
+        for (auto& p : previous)
+        {
+            if (p.option == newOrder[i])
+            {
+                tabs[i].x = p.x;
+                p.option = DSP_Option::END_OF_LIST;
+                break;
+            }
+        }
+    }
+
+    draggedSlot = -1;
+    startAnimating();
+}
+
+DSPOrderBar::DSP_Order DSPOrderBar::getOrder() const
+{
+    DSP_Order order;
+
+    for (size_t i = 0; i < tabs.size(); ++i)
+        order[i] = tabs[i].option;
+
+    return order;
+}
+
+float DSPOrderBar::getSlotWidth() const
+{
+    return static_cast<float>(getWidth()) / static_cast<float>(tabs.size());
+}
+
+float DSPOrderBar::getSlotX(size_t slot) const
+{
+    return getSlotWidth() * static_cast<float>(slot);
+}
+
+juce::Rectangle<int> DSPOrderBar::getTabBounds(float x) const
+{
+    return juce::Rectangle<float>(x, 0.f, getSlotWidth(), static_cast<float>(getHeight()))
+        .reduced(3.f)
+        .getSmallestIntegerContainer();
+}
+
+void DSPOrderBar::resized()
+{
+    for (size_t i = 0; i < tabs.size(); ++i)
+        tabs[i].x = getSlotX(i);
+}
+
+void DSPOrderBar::paint(juce::Graphics& g)
+{
+    g.fillAll(juce::Colour(0xff181b1f));
+    g.setFont(juce::Font(juce::FontOptions(13.f)));
+
+    auto drawTab = [&](size_t i)
+    {
+        auto r = getTabBounds(tabs[i].x).toFloat();
+        auto isDragged = static_cast<int>(i) == draggedSlot;
+
+        g.setColour(isDragged ? juce::Colour(0xfff0a030) : juce::Colour(0xff3c434b));
+        g.fillRoundedRectangle(r, 4.f);
+        g.setColour(isDragged ? juce::Colours::black : juce::Colours::white);
+        g.drawFittedText(juce::String(i + 1) + ". " + getOptionName(tabs[i].option),
+                         r.toNearestInt(), juce::Justification::centred, 1);
+    };
+
+    for (size_t i = 0; i < tabs.size(); ++i)
+        if (static_cast<int>(i) != draggedSlot)
+            drawTab(i);
+
+    //the dragged tab goes on top of the others
+    if (draggedSlot >= 0)
+        drawTab(static_cast<size_t>(draggedSlot));
+}
+
+void DSPOrderBar::mouseDown(const juce::MouseEvent& e)
+{
+    auto slot = juce::jlimit(0, static_cast<int>(tabs.size()) - 1,
+                             static_cast<int>(e.position.x / getSlotWidth()));
+
+    draggedSlot = slot;
+    dragGrabOffset = e.position.x - tabs[static_cast<size_t>(slot)].x;
+    orderAtDragStart = getOrder();
+    repaint(getTabBounds(tabs[static_cast<size_t>(slot)].x));
+}
+
+void DSPOrderBar::mouseDrag(const juce::MouseEvent& e)
+{
+    if (draggedSlot < 0)
+        return;
+
+    auto& dragged = tabs[static_cast<size_t>(draggedSlot)];
+    auto oldBounds = getTabBounds(dragged.x);
+
+    auto maxX = getSlotX(tabs.size() - 1);
+    dragged.x = juce::jlimit(0.f, maxX, e.position.x - dragGrabOffset);
+    repaint(oldBounds.getUnion(getTabBounds(dragged.x)));
+
+    auto newSlot = juce::jlimit(0, static_cast<int>(tabs.size()) - 1,
+                                juce::roundToInt(dragged.x / getSlotWidth()));
+
+    if (newSlot == draggedSlot)
+        return;
+
+    //shuffle the tabs in between by one slot, they animate into place
+    auto first = tabs.begin() + juce::jmin(newSlot, draggedSlot);
+    auto last = tabs.begin() + juce::jmax(newSlot, draggedSlot) + 1;
+
+    if (newSlot < draggedSlot)
+        std::rotate(first, last - 1, last);
+    else
+        std::rotate(first, first + 1, last);
+
+    draggedSlot = newSlot;
+    startAnimating();
+}
+
+void DSPOrderBar::mouseUp(const juce::MouseEvent&)
+{
+    if (draggedSlot < 0)
+        return;
+
+    draggedSlot = -1;
+    startAnimating();
+
+    auto newOrder = getOrder();
+
+    if (newOrder != orderAtDragStart && onOrderChanged)
+        onOrderChanged(newOrder);
+}
+
+void DSPOrderBar::startAnimating()
+{
+    if (! animating)
+    {
+        animationTimer->addClient(this);
+        animating = true;
+    }
+}
+
+void DSPOrderBar::animationTick()
+{
+    auto stillMoving = false;
+
+    for (size_t i = 0; i < tabs.size(); ++i)
+    {
+        if (static_cast<int>(i) == draggedSlot)
+        {
+            stillMoving = true;
+            continue;
+        }
+
+        auto target = getSlotX(i);
+        auto& x = tabs[i].x;
+
+        if (x == target)
+            continue;
+
+        auto oldBounds = getTabBounds(x);
+        x += (target - x) * 0.4f;
+
+        if (std::abs(target - x) < 0.5f)
+            x = target;
+        else
+            stillMoving = true;
+
+        repaint(oldBounds.getUnion(getTabBounds(x)));
+    }
+
+    if (! stillMoving)
+    {
+        animationTimer->removeClient(this);
+        animating = false;
+    }
+}
@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    DSPOrderBar.h
+    Drag-to-reorder strip for the processing chain.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../PluginProcessor.h"
+#include "SharedAnimationTimer.h"
+
+/**
+    Draws one tab per chain slot and lets the user drag them into a new order.
+    The tabs are painted by the bar itself rather than being child components,
+    so a moving tab only invalidates the strip it travels through. Tabs glide
+    into place using the shared animation timer and the bar unregisters as
+    soon as everything has settled.
+*/
+struct DSPOrderBar : juce::Component, private SharedAnimationTimer::Client
+{
+    using DSP_Option = Project13_NewAudioProcessor::DSP_Option;
+    using DSP_Order = Project13_NewAudioProcessor::DSP_Order;
+
+    DSPOrderBar();
+    ~DSPOrderBar() override;
+
+    /** shows a new order without notifying onOrderChanged */
+    void setOrder(const DSP_Order& newOrder);
+    DSP_Order getOrder() const;
+
+    std::function<void(const DSP_Order&)> onOrderChanged;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+    void mouseDown(const juce::MouseEvent& e) override;
+    void mouseDrag(const juce::MouseEvent& e) override;
+    void mouseUp(const juce::MouseEvent& e) override;
+
+    static juce::String getOptionName(DSP_Option option);
+
+private:
+    struct Tab
+    {
+        DSP_Option option = DSP_Option::END_OF_LIST;
+        float x = 0.f;
+    };
+
+    void animationTick() override;
+    void startAnimating();
+    float getSlotWidth() const;
+    float getSlotX(size_t slot) const;
+    juce::Rectangle<int> getTabBounds(float x) const;
+
+    std::array<Tab, std::tuple_size<DSP_Order>::value> tabs;
+
+    int draggedSlot = -1;
+    float dragGrabOffset = 0.f;
+    DSP_Order orderAtDragStart;
+
+    juce::SharedResourcePointer<SharedAnimationTimer> animationTimer;
+    bool animating = false;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (DSPOrderBar)
+};
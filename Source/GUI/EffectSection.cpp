@@ -0,0 +1,271 @@
+/*
+  ==============================================================================
+
+    EffectSection.cpp
+
+  ==============================================================================
+*/
+
+#include "EffectSection.h"
+
+namespace
+{
+const auto panelColour = juce::Colour(0xff22262b);
+const auto frameColour = juce::Colour(0xff3c434b);
+const auto accentColour = juce::Colour(0xfff0a030);
+const auto textColour = juce::Colours::white.withAlpha(0.85f);
+}
+
+//==============================================================================
+void SectionLookAndFeel::drawRotarySlider(juce::Graphics& g, int x, int y, int width, int height,
+                                          float sliderPosProportional, float rotaryStartAngle,
+                                          float rotaryEndAngle, juce::Slider& slider)
+{
+    auto bounds = juce::Rectangle<int>(x, y, width, height).toFloat().reduced(4.f);
+    auto size = juce::jmin(bounds.getWidth(), bounds.getHeight());
+    bounds = bounds.withSizeKeepingCentre(size, size);
+
+    auto centre = bounds.getCentre();
+    auto radius = size * 0.5f;
+    auto angle = juce::jmap(sliderPosProportional, rotaryStartAngle, rotaryEndAngle);
+    auto enabled = slider.isEnabled();
+
+    juce::Path track;
+    track.addCentredArc(centre.x, centre.y, radius - 3.f, radius - 3.f, 0.f,
+                        rotaryStartAngle, rotaryEndAngle, true);
+    g.setColour(frameColour);
+    g.strokePath(track, juce::PathStrokeType(3.f, juce::PathStrokeType::curved, juce::PathStrokeType::rounded));
+
+    juce::Path value;
+    value.addCentredArc(centre.x, centre.y, radius - 3.f, radius - 3.f, 0.f,
+                        rotaryStartAngle, angle, true);
+    g.setColour(enabled ? accentColour : accentColour.withSaturation(0.f));
+    g.strokePath(value, juce::PathStrokeType(3.f, juce::PathStrokeType::curved, juce::PathStrokeType::rounded));
+
+    auto tip = centre.getPointOnCircumference(radius - 9.f, angle);
+    g.setColour(textColour);
+    g.drawLine({ centre.getPointOnCircumference(radius * 0.25f, angle), tip }, 2.f);
+}
+
+//==============================================================================
+LfoIndicator::LfoIndicator(juce::AudioParameterFloat& rate, juce::AudioParameterBool& bypass)
+    : rateParam(rate), bypassParam(bypass)
+{
+    setInterceptsMouseClicks(false, false);
+}
+
+LfoIndicator::~LfoIndicator()
+{
+    if (registered)
+        animationTimer->removeClient(this);
+}
+
+void LfoIndicator::updateRegistration()
+{
+    auto shouldAnimate = isShowing() && ! bypassParam.get();
+
+    if (shouldAnimate == registered)
+        return;
+
+    if (shouldAnimate)
+        animationTimer->addClient(this);
+    else
+        animationTimer->removeClient(this);
+
+    registered = shouldAnimate;
+    repaint();
+}
+
+int LfoIndicator::getDotX() const
+{
+    auto seconds = juce::Time::getMillisecondCounterHiRes() * 0.001;
+    auto phase = std::fmod(seconds * static_cast<double>(rateParam.get()), 1.0);
+    auto travel = juce::jmax(0, getWidth() - getHeight());
+
+    //triangle so the dot sweeps back and forth like the modulation does
+    auto tri = phase < 0.5 ? phase * 2.0 : 2.0 - phase * 2.0;
+    return juce::roundToInt(tri * travel);
+}
+
+void LfoIndicator::animationTick()
+{
+    auto x = getDotX();
+
+    if (x != lastDotX)
+    {
+        lastDotX = x;
+        repaint();
+    }
+}
+
+void LfoIndicator::paint(juce::Graphics& g)
+{
+    auto h = static_cast<float>(getHeight());
+    auto lane = getLocalBounds().toFloat().reduced(h * 0.5f - 1.f, h * 0.5f - 1.f);
+
+    g.setColour(frameColour);
+    g.fillRect(lane);
+
+    if (! registered)
+        return;
+
+    g.setColour(accentColour);
+    g.fillEllipse(static_cast<float>(lastDotX), 0.f, h, h);
+}
+
+//==============================================================================
+EffectSection::EffectSection(const juce::String& sectionTitle,
+                             const std::vector<Control>& controlsToShow,
+                             juce::AudioParameterBool& bypass,
+                             juce::AudioParameterFloat* lfoRate)
+    : title(sectionTitle), controls(controlsToShow)
+{
+    setOpaque(true);
+
+    for (auto& c : controls)
+    {
+        jassert(c.param != nullptr || c.onClick != nullptr);
+
+        if (c.param == nullptr)
+        {
+            auto* button = editors.add(new juce::TextButton("Load..."));
+            button->onClick = c.onClick;
+            addAndMakeVisible(button);
+        }
+        else if (auto* choice = dynamic_cast<juce::AudioParameterChoice*>(c.param))
+        {
+            auto* combo = editors.add(new juce::ComboBox());
+            combo->addItemList(choice->choices, 1);
+            comboAttachments.add(new juce::ComboBoxParameterAttachment(*choice, *combo));
+            addAndMakeVisible(combo);
+        }
+        else if (auto* toggle = dynamic_cast<juce::AudioParameterBool*>(c.param))
+        {
+            auto* button = editors.add(new juce::ToggleButton());
+            buttonAttachments.add(new juce::ButtonParameterAttachment(*toggle, *button));
+            addAndMakeVisible(button);
+        }
+        else
+        {
+            auto* slider = editors.add(new juce::Slider(juce::Slider::RotaryHorizontalVerticalDrag,
+                                                        juce::Slider::TextBoxBelow));
+            slider->setLookAndFeel(&lnf);
+            slider->setTextBoxStyle(juce::Slider::TextBoxBelow, true, knobSize, captionHeight);
+            slider->setColour(juce::Slider::textBoxOutlineColourId, juce::Colours::transparentBlack);
+            sliderAttachments.add(new juce::SliderParameterAttachment(*c.param, *slider, nullptr));
+            addAndMakeVisible(slider);
+        }
+    }
+
+    bypassButton.setButtonText("Bypass");
+    bypassAttachment = std::make_unique<juce::ButtonParameterAttachment>(bypass, bypassButton);
+    addAndMakeVisible(bypassButton);
+
+    if (lfoRate != nullptr)
+    {
+        lfoIndicator = std::make_unique<LfoIndicator>(*lfoRate, bypass);
+        addAndMakeVisible(*lfoIndicator);
+    }
+
+    //fires for clicks as well as host automation pushed through the attachment
+    bypassButton.onClick = [this]()
+    {
+        for (auto* e : editors)
+            e->setEnabled(! bypassButton.getToggleState());
+
+        if (lfoIndicator != nullptr)
+            lfoIndicator->updateRegistration();
+    };
+    bypassButton.onClick();
+}
+
+EffectSection::~EffectSection()
+{
+    for (auto* e : editors)
+        e->setLookAndFeel(nullptr);
+}
+
+std::vector<juce::Rectangle<int>> EffectSection::getControlCells() const
+{
+    std::vector<juce::Rectangle<int>> cells;
+
+    auto area = getLocalBounds().reduced(6).withTrimmedTop(titleHeight);
+    auto cellW = area.getWidth() / columns;
+    auto cellH = knobSize + captionHeight * 2;
+
+    for (size_t i = 0; i < controls.size(); ++i)
+    {
+        auto col = static_cast<int>(i) % columns;
+        auto row = static_cast<int>(i) / columns;
+        cells.emplace_back(area.getX() + col * cellW, area.getY() + row * cellH, cellW, cellH);
+    }
+
+    return cells;
+}
+
+void EffectSection::resized()
+{
+    auto titleBar = getLocalBounds().reduced(6).removeFromTop(titleHeight);
+    bypassButton.setBounds(titleBar.removeFromRight(70));
+
+    if (lfoIndicator != nullptr)
+        lfoIndicator->setBounds(titleBar.removeFromRight(40).withSizeKeepingCentre(40, 8));
+
+    auto cells = getControlCells();
+
+    for (size_t i = 0; i < cells.size(); ++i)
+    {
+        auto cell = cells[i].withTrimmedTop(captionHeight);
+        auto* e = editors[static_cast<int>(i)];
+
+        if (dynamic_cast<juce::ComboBox*>(e) != nullptr)
+            e->setBounds(cell.withSizeKeepingCentre(cell.getWidth() - 8, 22));
+        else if (dynamic_cast<juce::ToggleButton*>(e) != nullptr)
+            e->setBounds(cell.withSizeKeepingCentre(24, 24));
+        else if (dynamic_cast<juce::TextButton*>(e) != nullptr)
+            e->setBounds(cell.withSizeKeepingCentre(cell.getWidth() - 8, 24));
+        else
+            e->setBounds(cell.withSizeKeepingCentre(knobSize, knobSize + captionHeight));
+    }
+
+    renderBackground();
+}
+
+void EffectSection::renderBackground()
+{
+    auto scale = 1.f;
+
+    if (auto* display = juce::Desktop::getInstance().getDisplays().getDisplayForRect(getScreenBounds()))
+        scale = static_cast<float>(display->scale);
+
+    auto w = juce::jmax(1, juce::roundToInt(getWidth() * scale));
+    auto h = juce::jmax(1, juce::roundToInt(getHeight() * scale));
+    backgroundCache = juce::Image(juce::Image::RGB, w, h, false);
+
+    juce::Graphics g(backgroundCache);
+    g.addTransform(juce::AffineTransform::scale(scale));
+
+    g.fillAll(panelColour);
+    g.setColour(frameColour);
+    g.drawRoundedRectangle(getLocalBounds().toFloat().reduced(1.5f), 4.f, 1.f);
+
+    auto titleBar = getLocalBounds().reduced(6).removeFromTop(titleHeight);
+    g.setColour(textColour);
+    g.setFont(juce::Font(juce::FontOptions(15.f, juce::Font::bold)));
+    g.drawFittedText(title, titleBar, juce::Justification::centredLeft, 1);
+
+    g.setFont(juce::Font(juce::FontOptions(12.f)));
+    auto cells = getControlCells();
+
+    for (size_t i = 0; i < cells.size(); ++i)
+        g.drawFittedText(controls[i].label, cells[i].removeFromTop(captionHeight),
+                         juce::Justification::centred, 1);
+}
+
+void EffectSection::paint(juce::Graphics& g)
+{
+    if (backgroundCache.isValid())
+        g.drawImage(backgroundCache, getLocalBounds().toFloat());
+    else
+        g.fillAll(panelColour);
+}
@@ -0,0 +1,106 @@
+/*
+  ==============================================================================
+
+    EffectSection.h
+    The controls for one stage of the DSP chain.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "SharedAnimationTimer.h"
+
+//==============================================================================
+/** Knob drawing kept to a single arc so a moving knob is cheap to repaint. */
+struct SectionLookAndFeel : juce::LookAndFeel_V4
+{
+    void drawRotarySlider(juce::Graphics& g, int x, int y, int width, int height,
+                          float sliderPosProportional, float rotaryStartAngle,
+                          float rotaryEndAngle, juce::Slider& slider) override;
+};
+
+//==============================================================================
+/**
+    Small dot that sweeps at the rate of a modulation parameter. It only
+    listens to the shared timer while it is showing and its stage is active,
+    and it only repaints its own bounds when the dot has actually moved.
+*/
+struct LfoIndicator : juce::Component, private SharedAnimationTimer::Client
+{
+    LfoIndicator(juce::AudioParameterFloat& rate, juce::AudioParameterBool& bypass);
+    ~LfoIndicator() override;
+
+    void paint(juce::Graphics& g) override;
+    void visibilityChanged() override { updateRegistration(); }
+    void parentHierarchyChanged() override { updateRegistration(); }
+
+    /** called by the owning section when the bypass button changes */
+    void updateRegistration();
+
+private:
+    void animationTick() override;
+    int getDotX() const;
+
+    juce::AudioParameterFloat& rateParam;
+    juce::AudioParameterBool& bypassParam;
+    juce::SharedResourcePointer<SharedAnimationTimer> animationTimer;
+
+    bool registered = false;
+    int lastDotX = -1;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (LfoIndicator)
+};
+
+//==============================================================================
+/**
+    Everything that never changes (frame, title, knob captions) is rendered
+    into backgroundCache once per resize, so paint() is a single image blit
+    and a moving knob only repaints the knob's own bounds.
+*/
+struct EffectSection : juce::Component
+{
+    struct Control
+    {
+        juce::RangedAudioParameter* param = nullptr;
+        juce::String label;
+        /** with no param, the cell is a button that calls this, e.g. to open a file */
+        std::function<void()> onClick;
+    };
+
+    EffectSection(const juce::String& sectionTitle,
+                  const std::vector<Control>& controls,
+                  juce::AudioParameterBool& bypass,
+                  juce::AudioParameterFloat* lfoRate = nullptr);
+    ~EffectSection() override;
+
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+
+    static constexpr int titleHeight = 24;
+    static constexpr int knobSize = 78;
+    static constexpr int captionHeight = 14;
+    static constexpr int columns = 2;
+
+private:
+    void renderBackground();
+    std::vector<juce::Rectangle<int>> getControlCells() const;
+
+    juce::String title;
+    std::vector<Control> controls;
+
+    juce::Image backgroundCache;
+
+    SectionLookAndFeel lnf;
+    juce::OwnedArray<juce::Component> editors;
+    juce::OwnedArray<juce::SliderParameterAttachment> sliderAttachments;
+    juce::OwnedArray<juce::ComboBoxParameterAttachment> comboAttachments;
+    juce::OwnedArray<juce::ButtonParameterAttachment> buttonAttachments;
+
+    juce::ToggleButton bypassButton;
+    std::unique_ptr<juce::ButtonParameterAttachment> bypassAttachment;
+    std::unique_ptr<LfoIndicator> lfoIndicator;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (EffectSection)
+};
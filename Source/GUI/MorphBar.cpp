@@ -0,0 +1,69 @@
+/*
+  ==============================================================================
+
+    MorphBar.cpp
+
+  ==============================================================================
+*/
+
+#include "MorphBar.h"
+
+MorphBar::MorphBar(Project13_NewAudioProcessor& p)
+    : audioProcessor(p),
+      enabledAttachment(*p.morphEnabled, enabledButton),
+      positionAttachment(*p.morphPosition, positionSlider, nullptr)
+{
+    addAndMakeVisible(enabledButton);
+    addAndMakeVisible(positionSlider);
+
+    for (size_t slot = 0; slot < slotButtons.size(); ++slot)
+    {
+        auto& button = slotButtons[slot];
+        button.setButtonText(juce::String::charToString(static_cast<juce::juce_wchar>('A' + slot)));
+        button.setTooltip("Click to capture the current settings, shift-click to clear");
+        button.onClick = [this, slot]()
+        {
+            if (juce::ModifierKeys::currentModifiers.isShiftDown())
+                audioProcessor.clearMorphSnapshot(slot);
+            else
+                audioProcessor.captureMorphSnapshot(slot);
+        };
+        addAndMakeVisible(button);
+    }
+
+    audioProcessor.morphSnapshotBroadcaster.addChangeListener(this);
+    refreshSlotButtons();
+}
+
+MorphBar::~MorphBar()
+{
+    audioProcessor.morphSnapshotBroadcaster.removeChangeListener(this);
+}
+
+void MorphBar::changeListenerCallback(juce::ChangeBroadcaster*)
+{
+    refreshSlotButtons();
+}
+
+void MorphBar::refreshSlotButtons()
+{
+    for (size_t slot = 0; slot < slotButtons.size(); ++slot)
+    {
+        auto captured = audioProcessor.hasMorphSnapshot(slot);
+        slotButtons[slot].setColour(juce::TextButton::buttonColourId,
+                                    captured ? juce::Colour(0xfff0a030) : juce::Colour(0xff3c434b));
+        slotButtons[slot].setColour(juce::TextButton::textColourOffId,
+                                    captured ? juce::Colours::black : juce::Colours::white);
+    }
+}
+
+void MorphBar::resized()
+{
+    auto bounds = getLocalBounds();
+    enabledButton.setBounds(bounds.removeFromLeft(80));
+
+    for (auto& button : slotButtons)
+        button.setBounds(bounds.removeFromLeft(32).reduced(2));
+
+    positionSlider.setBounds(bounds.reduced(4, 0));
+}
@@ -0,0 +1,41 @@
+/*
+  ==============================================================================
+
+    MorphBar.h
+    Snapshot capture buttons and the morph control.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+#include "../PluginProcessor.h"
+
+/**
+    Click a slot to capture the current settings into it, shift-click to clear
+    it. The slider sweeps through the captured slots in order.
+*/
+struct MorphBar : juce::Component, private juce::ChangeListener
+{
+    explicit MorphBar(Project13_NewAudioProcessor& p);
+    ~MorphBar() override;
+
+    void resized() override;
+
+private:
+    void changeListenerCallback(juce::ChangeBroadcaster*) override;
+    void refreshSlotButtons();
+
+    Project13_NewAudioProcessor& audioProcessor;
+
+    juce::ToggleButton enabledButton { "Morph" };
+    juce::ButtonParameterAttachment enabledAttachment;
+
+    juce::Slider positionSlider { juce::Slider::LinearHorizontal, juce::Slider::NoTextBox };
+    juce::SliderParameterAttachment positionAttachment;
+
+    std::array<juce::TextButton, Project13_NewAudioProcessor::Morpher::maxSnapshots> slotButtons;
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (MorphBar)
+};
@@ -0,0 +1,55 @@
+/*
+  ==============================================================================
+
+    SharedAnimationTimer.h
+    One rate-limited timer for every open editor in the host process.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    Hold one of these through a juce::SharedResourcePointer. However many
+    editors are open, there is a single timer ticking at frameRateHz, and it
+    only runs while at least one client is registered. Clients register when
+    they have something to animate and unregister as soon as they are done.
+*/
+struct SharedAnimationTimer : private juce::Timer
+{
+    struct Client
+    {
+        virtual ~Client() = default;
+        virtual void animationTick() = 0;
+    };
+
+    static constexpr int frameRateHz = 30;
+
+    ~SharedAnimationTimer() override { stopTimer(); }
+
+    void addClient(Client* client)
+    {
+        clients.add(client);
+
+        if (! isTimerRunning())
+            startTimerHz(frameRateHz);
+    }
+
+    void removeClient(Client* client)
+    {
+        clients.remove(client);
+
+        if (clients.isEmpty())
+            stopTimer();
+    }
+
+private:
+    void timerCallback() override
+    {
+        clients.call([](Client& c) { c.animationTick(); });
+    }
+
+    juce::ListenerList<Client> clients;
+};
@@ -0,0 +1,110 @@
+/*
+  ==============================================================================
+
+    ControlPipe.cpp
+
+  ==============================================================================
+*/
+
+#include "ControlPipe.h"
+
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <iostream>
+
+ControlPipe::ControlPipe(const juce::String& pipePath, juce::AudioProcessorValueTreeState& state)
+    : juce::Thread("Control pipe"), apvts(state)
+{
+    //opened read-write, a named pipe never reports end of file, so controllers can connect and disconnect freely
+    fd = ::open(pipePath.toRawUTF8(), O_RDWR | O_NONBLOCK);
+}
+
+ControlPipe::~ControlPipe()
+{
+    stopThread(1000);
+
+    if (fd >= 0)
+        ::close(fd);
+}
+
+void ControlPipe::applyPending()
+{
+    auto scope = fifo.read(fifo.getNumReady());
+
+    scope.forEach([this](int index)
+    {
+        auto& change = pending[static_cast<size_t>(index)];
+        change.parameter->setValueNotifyingHost(change.normalisedValue);
+    });
+}
+
+void ControlPipe::handleLine(const juce::String& line)
+{
+    auto text = line.trim();
+
+    if (text.isEmpty() || text.startsWithChar('#'))
+        return;
+
+    auto split = text.lastIndexOfChar(' ');
+
+    if (split < 0)
+    {
+        std::cerr << "control: expected '<parameter id> <value>', got '" << text << "'" << std::endl;
+        return;
+    }
+
+    auto id = text.substring(0, split).trim();
+    auto value = text.substring(split + 1);
+    auto* parameter = apvts.getParameter(id);
+
+    if (parameter == nullptr)
+    {
+        std::cerr << "control: no parameter '" << id << "'" << std::endl;
+        return;
+    }
+
+    if (fifo.getFreeSpace() == 0)
+    {
+        std::cerr << "control: too many pending changes, dropped '" << text << "'" << std::endl;
+        return;
+    }
+
+    auto scope = fifo.write(1);
+
+    scope.forEach([&](int index)
+    {
+        pending[static_cast<size_t>(index)] = { parameter, parameter->getValueForText(value) };
+    });
+}
+
+void ControlPipe::run()
+{
+    juce::MemoryBlock partialLine;
+    char chunk[1024];
+
+    while (! threadShouldExit())
+    {
+        pollfd request { fd, POLLIN, 0 };
+
+        if (::poll(&request, 1, 100) <= 0)
+            continue;
+
+        auto numRead = ::read(fd, chunk, sizeof(chunk));
+
+        if (numRead <= 0)
+            continue;
+
+        for (ssize_t i = 0; i < numRead; ++i)
+        {
+            if (chunk[i] != '\n')
+            {
+                partialLine.append(chunk + i, 1);
+                continue;
+            }
+
+            handleLine(partialLine.toString());
+            partialLine.reset();
+        }
+    }
+}
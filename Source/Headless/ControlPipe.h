@@ -0,0 +1,61 @@
+/*
+  ==============================================================================
+
+    ControlPipe.h
+    Parameter changes for the headless stream, one per line on a named pipe.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/**
+    Each line is a parameter ID followed by a value, e.g.
+
+        Phaser ratehz 2.5
+        Band 2 General Filter Topology SVF
+        Phaser Bypass on
+
+    The value is the last word and is read the way the parameter reads its own
+    text: plain units for floats, the choice name for choices and on/off or
+    1/0 for bools. IDs may contain spaces. Unknown IDs are reported on stderr
+    and skipped.
+
+    A thread reads and parses the lines; the DSP thread applies the changes
+    between blocks with applyPending(), so a change never lands mid-block.
+*/
+class ControlPipe : public juce::Thread
+{
+public:
+    static constexpr int maxPending = 256;
+
+    ControlPipe(const juce::String& pipePath, juce::AudioProcessorValueTreeState& state);
+    ~ControlPipe() override;
+
+    /** false if the pipe could not be opened */
+    bool isOpen() const { return fd >= 0; }
+
+    /** DSP thread, between blocks */
+    void applyPending();
+
+    void run() override;
+
+private:
+    struct Change
+    {
+        juce::RangedAudioParameter* parameter = nullptr;
+        float normalisedValue = 0.f;
+    };
+
+    void handleLine(const juce::String& line);
+
+    juce::AudioProcessorValueTreeState& apvts;
+    int fd = -1;
+
+    std::array<Change, maxPending> pending;
+    juce::AbstractFifo fifo { maxPending };
+
+    JUCE_DECLARE_NON_COPYABLE(ControlPipe)
+};
@@ -0,0 +1,298 @@
+/*
+  ==============================================================================
+
+    PcmPipe.cpp
+
+  ==============================================================================
+*/
+
+#include "PcmPipe.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+bool parsePcmFormat(const juce::String& text, PcmFormat& format)
+{
+    if (text == "f32") { format = PcmFormat::Float32; return true; }
+    if (text == "s16") { format = PcmFormat::Int16; return true; }
+    if (text == "s24") { format = PcmFormat::Int24; return true; }
+    if (text == "s32") { format = PcmFormat::Int32; return true; }
+
+    return false;
+}
+
+int getBytesPerSample(PcmFormat format)
+{
+    switch (format)
+    {
+        case PcmFormat::Float32: return 4;
+        case PcmFormat::Int16: return 2;
+        case PcmFormat::Int24: return 3;
+        case PcmFormat::Int32: return 4;
+    }
+
+    return 4;
+}
+
+namespace
+{
+    using FloatBuffer = juce::AudioData::Format<juce::AudioData::Float32, juce::AudioData::NativeEndian>;
+
+    template <typename SampleType>
+    void deinterleaveAs(const void* source, juce::AudioBuffer<float>& dest, int numFrames)
+    {
+        using Pcm = juce::AudioData::Format<SampleType, juce::AudioData::LittleEndian>;
+        auto numChannels = dest.getNumChannels();
+
+        juce::AudioData::deinterleaveSamples(juce::AudioData::InterleavedSource<Pcm> { source, numChannels },
+                                             juce::AudioData::NonInterleavedDest<FloatBuffer> { dest.getArrayOfWritePointers(), numChannels },
+                                             numFrames);
+    }
+
+    template <typename SampleType>
+    void interleaveAs(const juce::AudioBuffer<float>& source, void* dest, int numFrames)
+    {
+        using Pcm = juce::AudioData::Format<SampleType, juce::AudioData::LittleEndian>;
+        auto numChannels = source.getNumChannels();
+
+        juce::AudioData::interleaveSamples(juce::AudioData::NonInterleavedSource<FloatBuffer> { source.getArrayOfReadPointers(), numChannels },
+                                           juce::AudioData::InterleavedDest<Pcm> { dest, numChannels },
+                                           numFrames);
+    }
+}
+
+void deinterleavePcm(PcmFormat format, const void* source, juce::AudioBuffer<float>& dest, int numFrames)
+{
+    switch (format)
+    {
+        case PcmFormat::Float32: deinterleaveAs<juce::AudioData::Float32>(source, dest, numFrames); break;
+        case PcmFormat::Int16: deinterleaveAs<juce::AudioData::Int16>(source, dest, numFrames); break;
+        case PcmFormat::Int24: deinterleaveAs<juce::AudioData::Int24>(source, dest, numFrames); break;
+        case PcmFormat::Int32: deinterleaveAs<juce::AudioData::Int32>(source, dest, numFrames); break;
+    }
+}
+
+void interleavePcm(PcmFormat format, const juce::AudioBuffer<float>& source, void* dest, int numFrames)
+{
+    switch (format)
+    {
+        case PcmFormat::Float32: interleaveAs<juce::AudioData::Float32>(source, dest, numFrames); break;
+        case PcmFormat::Int16: interleaveAs<juce::AudioData::Int16>(source, dest, numFrames); break;
+        case PcmFormat::Int24: interleaveAs<juce::AudioData::Int24>(source, dest, numFrames); break;
+        case PcmFormat::Int32: interleaveAs<juce::AudioData::Int32>(source, dest, numFrames); break;
+    }
+}
+
+//==============================================================================
+std::unique_ptr<PipeFile> PipeFile::openForReading(const juce::String& path)
+{
+    if (path == "-")
+        return std::unique_ptr<PipeFile>(new PipeFile(STDIN_FILENO, false));
+
+    //opening a named pipe waits here until the other end opens it too
+    auto fd = ::open(path.toRawUTF8(), O_RDONLY);
+    return fd < 0 ? nullptr : std::unique_ptr<PipeFile>(new PipeFile(fd, true));
+}
+
+std::unique_ptr<PipeFile> PipeFile::openForWriting(const juce::String& path)
+{
+    if (path == "-")
+        return std::unique_ptr<PipeFile>(new PipeFile(STDOUT_FILENO, false));
+
+    auto fd = ::open(path.toRawUTF8(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    return fd < 0 ? nullptr : std::unique_ptr<PipeFile>(new PipeFile(fd, true));
+}
+
+PipeFile::~PipeFile()
+{
+    if (ownsFd)
+        ::close(fd);
+}
+
+bool PipeFile::waitForData(int timeoutMs)
+{
+    pollfd request { fd, POLLIN, 0 };
+    return ::poll(&request, 1, timeoutMs) != 0;
+}
+
+int PipeFile::read(void* dest, int maxBytes)
+{
+    for (;;)
+    {
+        auto result = ::read(fd, dest, static_cast<size_t>(maxBytes));
+
+        if (result >= 0)
+            return static_cast<int>(result);
+
+        if (errno != EINTR)
+            return 0;
+    }
+}
+
+bool PipeFile::writeFully(const void* source, int numBytes)
+{
+    auto* data = static_cast<const char*>(source);
+
+    while (numBytes > 0)
+    {
+        auto result = ::write(fd, data, static_cast<size_t>(numBytes));
+
+        if (result < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            return false;
+        }
+
+        data += result;
+        numBytes -= static_cast<int>(result);
+    }
+
+    return true;
+}
+
+//==============================================================================
+BlockQueue::BlockQueue(int numSlots, int bytesPerSlot)
+    : slots(static_cast<size_t>(numSlots + 1)), fifo(numSlots + 1)
+{
+    for (auto& slot : slots)
+        slot.bytes.calloc(static_cast<size_t>(bytesPerSlot));
+}
+
+BlockQueue::Slot* BlockQueue::waitForEmpty()
+{
+    while (fifo.getFreeSpace() == 0)
+    {
+        if (isClosed())
+            return nullptr;
+
+        slotFreed.wait(50);
+    }
+
+    if (isClosed())
+        return nullptr;
+
+    int start1, size1, start2, size2;
+    fifo.prepareToWrite(1, start1, size1, start2, size2);
+    return &slots[static_cast<size_t>(start1)];
+}
+
+void BlockQueue::publish()
+{
+    fifo.finishedWrite(1);
+    slotFilled.signal();
+}
+
+BlockQueue::Slot* BlockQueue::waitForFull()
+{
+    //closing is checked before looking, so a block published just before close() is never missed
+    for (;;)
+    {
+        auto wasClosed = isClosed();
+
+        if (fifo.getNumReady() > 0)
+            break;
+
+        if (wasClosed)
+            return nullptr;
+
+        slotFilled.wait(50);
+    }
+
+    int start1, size1, start2, size2;
+    fifo.prepareToRead(1, start1, size1, start2, size2);
+    return &slots[static_cast<size_t>(start1)];
+}
+
+void BlockQueue::release()
+{
+    fifo.finishedRead(1);
+    slotFreed.signal();
+}
+
+void BlockQueue::close()
+{
+    closed.store(true, std::memory_order_release);
+    slotFilled.signal();
+    slotFreed.signal();
+}
+
+//==============================================================================
+PcmReader::PcmReader(PipeFile& source, BlockQueue& destination, int bytesPerBlock, int bytesPerFrame)
+    : juce::Thread("PCM reader"), file(source), queue(destination), blockBytes(bytesPerBlock), frameBytes(bytesPerFrame)
+{
+}
+
+PcmReader::~PcmReader()
+{
+    stopThread(1000);
+}
+
+void PcmReader::run()
+{
+    auto endOfStream = false;
+
+    while (! endOfStream && ! threadShouldExit())
+    {
+        auto* slot = queue.waitForEmpty();
+
+        if (slot == nullptr)
+            break;
+
+        //a pipe hands data over in whatever pieces the writer used, so keep reading until the block is full
+        slot->numBytes = 0;
+
+        while (slot->numBytes < blockBytes && ! threadShouldExit())
+        {
+            if (! file.waitForData(100))
+                continue;
+
+            auto numRead = file.read(slot->bytes + slot->numBytes, blockBytes - slot->numBytes);
+
+            if (numRead == 0)
+            {
+                endOfStream = true;
+                break;
+            }
+
+            slot->numBytes += numRead;
+        }
+
+        //a trailing partial frame can't be processed
+        slot->numBytes -= slot->numBytes % frameBytes;
+
+        if (slot->numBytes > 0)
+            queue.publish();
+    }
+
+    queue.close();
+}
+
+//==============================================================================
+PcmWriter::PcmWriter(PipeFile& destination, BlockQueue& source)
+    : juce::Thread("PCM writer"), file(destination), queue(source)
+{
+}
+
+PcmWriter::~PcmWriter()
+{
+    stopThread(1000);
+}
+
+void PcmWriter::run()
+{
+    while (auto* slot = queue.waitForFull())
+    {
+        if (! file.writeFully(slot->bytes, slot->numBytes))
+        {
+            failed.store(true, std::memory_order_release);
+            queue.close();
+            return;
+        }
+
+        queue.release();
+    }
+}
@@ -0,0 +1,127 @@
+/*
+  ==============================================================================
+
+    PcmPipe.h
+    Raw interleaved PCM over stdin/stdout or named pipes, moved by I/O
+    threads through small block queues so the DSP thread never blocks on a
+    pipe.
+
+  ==============================================================================
+*/
+
+#pragma once
+
+#include <JuceHeader.h>
+
+/** interleaved, little endian */
+enum class PcmFormat { Float32, Int16, Int24, Int32 };
+
+/** "f32", "s16", "s24" or "s32"; false for anything else */
+bool parsePcmFormat(const juce::String& text, PcmFormat& format);
+int getBytesPerSample(PcmFormat format);
+
+void deinterleavePcm(PcmFormat format, const void* source, juce::AudioBuffer<float>& dest, int numFrames);
+/** integer formats clip at full scale */
+void interleavePcm(PcmFormat format, const juce::AudioBuffer<float>& source, void* dest, int numFrames);
+
+//==============================================================================
+/**
+    A file descriptor: stdin or stdout for "-", otherwise a file or a named
+    pipe opened by path. POSIX only, like the Linux build this ships with.
+*/
+class PipeFile
+{
+public:
+    static std::unique_ptr<PipeFile> openForReading(const juce::String& path);
+    static std::unique_ptr<PipeFile> openForWriting(const juce::String& path);
+    ~PipeFile();
+
+    /** false when nothing arrived within the timeout */
+    bool waitForData(int timeoutMs);
+    /** one read of whatever is there, up to maxBytes; 0 at the end of the stream */
+    int read(void* dest, int maxBytes);
+    /** blocks until everything is written; false once the reader has gone */
+    bool writeFully(const void* source, int numBytes);
+
+private:
+    PipeFile(int fileDescriptor, bool shouldClose) : fd(fileDescriptor), ownsFd(shouldClose) {}
+
+    int fd = -1;
+    bool ownsFd = false;
+
+    JUCE_DECLARE_NON_COPYABLE(PipeFile)
+};
+
+//==============================================================================
+/**
+    A single-producer single-consumer queue of preallocated byte blocks.
+    With two slots one block is filled or drained by the I/O thread while the
+    DSP thread works on the other.
+
+    Either side can close() the queue: the producer when its stream ends, the
+    consumer when it gives up. After that the producer gets no more empty
+    slots, and the consumer gets the full ones still queued, then none.
+*/
+class BlockQueue
+{
+public:
+    struct Slot
+    {
+        juce::HeapBlock<char> bytes;
+        int numBytes = 0;
+    };
+
+    BlockQueue(int numSlots, int bytesPerSlot);
+
+    /** producer; waits for a free slot, nullptr once closed */
+    Slot* waitForEmpty();
+    void publish();
+
+    /** consumer; waits for a full slot, nullptr once closed and drained */
+    Slot* waitForFull();
+    void release();
+
+    void close();
+    bool isClosed() const { return closed.load(std::memory_order_acquire); }
+
+private:
+    //an AbstractFifo keeps one slot spare
+    std::vector<Slot> slots;
+    juce::AbstractFifo fifo;
+    juce::WaitableEvent slotFilled, slotFreed;
+    std::atomic<bool> closed { false };
+
+    JUCE_DECLARE_NON_COPYABLE(BlockQueue)
+};
+
+//==============================================================================
+/** fills a BlockQueue from a PipeFile, whole frames at a time, until the stream ends */
+class PcmReader : public juce::Thread
+{
+public:
+    PcmReader(PipeFile& source, BlockQueue& destination, int bytesPerBlock, int bytesPerFrame);
+    ~PcmReader() override;
+    void run() override;
+
+private:
+    PipeFile& file;
+    BlockQueue& queue;
+    const int blockBytes, frameBytes;
+};
+
+/** drains a BlockQueue into a PipeFile until the queue closes or the reader goes away */
+class PcmWriter : public juce::Thread
+{
+public:
+    PcmWriter(PipeFile& destination, BlockQueue& source);
+    ~PcmWriter() override;
+    void run() override;
+
+    /** true when the other end stopped reading; the DSP thread should stop too */
+    bool hasFailed() const { return failed.load(std::memory_order_acquire); }
+
+private:
+    PipeFile& file;
+    BlockQueue& queue;
+    std::atomic<bool> failed { false };
+};
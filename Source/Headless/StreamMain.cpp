@@ -0,0 +1,200 @@
+/*
+  ==============================================================================
+
+    StreamMain.cpp
+    Project13_Stream: runs the processor headless on raw PCM from stdin or a
+    named pipe and writes the result to stdout, for chaining between tools.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../PluginProcessor.h"
+#include "PcmPipe.h"
+#include "ControlPipe.h"
+
+#include <csignal>
+#include <iostream>
+
+namespace
+{
+    constexpr auto usage =
+        "Project13_Stream [options]\n"
+        "  --input=<path|->      interleaved PCM in, stdin by default\n"
+        "  --output=<path|->     processed PCM out, stdout by default\n"
+        "  --format=<f32|s16|s24|s32>  little endian sample format, default f32\n"
+        "  --rate=<hz>           default 48000\n"
+        "  --channels=<1|2>      default 2\n"
+        "  --block=<frames>      frames per processBlock, default 256\n"
+        "  --state=<file>        state saved by the plugin, loaded before streaming\n"
+        "  --control=<fifo>      named pipe of '<parameter id> <value>' lines\n"
+        "  --offline             process as an offline bounce: every stage ready from\n"
+        "                        the first block, convolution tails always complete\n";
+
+    struct StreamOptions
+    {
+        juce::String inputPath = "-", outputPath = "-", statePath, controlPath;
+        PcmFormat format = PcmFormat::Float32;
+        double sampleRate = 48000.0;
+        int numChannels = 2;
+        int blockSize = 256;
+        bool offline = false;
+    };
+
+    StreamOptions parseOptions(const juce::ArgumentList& args)
+    {
+        StreamOptions options;
+
+        auto valueOf = [&args](const juce::String& option, const juce::String& fallback)
+        {
+            return args.containsOption(option) ? args.getValueForOption(option) : fallback;
+        };
+
+        options.inputPath = valueOf("--input", options.inputPath);
+        options.outputPath = valueOf("--output", options.outputPath);
+        options.statePath = valueOf("--state", {});
+        options.controlPath = valueOf("--control", {});
+        options.sampleRate = valueOf("--rate", "48000").getDoubleValue();
+        options.numChannels = valueOf("--channels", "2").getIntValue();
+        options.blockSize = valueOf("--block", "256").getIntValue();
+        options.offline = args.containsOption("--offline");
+
+        if (! parsePcmFormat(valueOf("--format", "f32"), options.format))
+            juce::ConsoleApplication::fail("unknown --format, expected f32, s16, s24 or s32");
+
+        if (options.sampleRate < 8000.0 || options.sampleRate > 768000.0)
+            juce::ConsoleApplication::fail("--rate out of range");
+
+        if (options.numChannels != 1 && options.numChannels != 2)
+            juce::ConsoleApplication::fail("--channels must be 1 or 2");
+
+        if (options.blockSize < 1 || options.blockSize > 65536)
+            juce::ConsoleApplication::fail("--block out of range");
+
+        return options;
+    }
+
+    void loadState(Project13_NewAudioProcessor& processor, const juce::String& path)
+    {
+        juce::File file(juce::File::getCurrentWorkingDirectory().getChildFile(path));
+        juce::MemoryBlock blob;
+
+        if (! file.loadFileAsData(blob) || blob.isEmpty())
+            juce::ConsoleApplication::fail("could not read --state " + file.getFullPathName());
+
+        processor.setStateInformation(blob.getData(), static_cast<int>(blob.getSize()));
+    }
+
+    int stream(const StreamOptions& options)
+    {
+        Project13_NewAudioProcessor processor;
+
+        auto layout = juce::AudioChannelSet::canonicalChannelSet(options.numChannels);
+        juce::AudioProcessor::BusesLayout buses;
+        buses.inputBuses.add(layout);
+        buses.outputBuses.add(layout);
+
+        if (! processor.setBusesLayout(buses))
+            juce::ConsoleApplication::fail("channel layout not supported");
+
+        processor.setNonRealtime(options.offline);
+
+        if (options.statePath.isNotEmpty())
+            loadState(processor, options.statePath);
+
+        std::unique_ptr<ControlPipe> control;
+
+        if (options.controlPath.isNotEmpty())
+        {
+            control = std::make_unique<ControlPipe>(options.controlPath, processor.apvts);
+
+            if (! control->isOpen())
+                juce::ConsoleApplication::fail("could not open --control " + options.controlPath);
+        }
+
+        processor.prepareToPlay(options.sampleRate, options.blockSize);
+
+        auto frameBytes = options.numChannels * getBytesPerSample(options.format);
+        auto blockBytes = frameBytes * options.blockSize;
+
+        auto input = PipeFile::openForReading(options.inputPath);
+        auto output = PipeFile::openForWriting(options.outputPath);
+
+        if (input == nullptr)
+            juce::ConsoleApplication::fail("could not open --input " + options.inputPath);
+
+        if (output == nullptr)
+            juce::ConsoleApplication::fail("could not open --output " + options.outputPath);
+
+        std::cerr << "Project13_Stream: " << options.numChannels << " ch, " << options.sampleRate << " Hz, "
+                  << options.blockSize << " frames per block, latency " << processor.getLatencySamples()
+                  << " samples" << std::endl;
+
+        //two blocks each way: the I/O threads fill and drain one while the DSP loop works on the other
+        BlockQueue inputQueue(2, blockBytes), outputQueue(2, blockBytes);
+        PcmReader reader(*input, inputQueue, blockBytes, frameBytes);
+        PcmWriter writer(*output, outputQueue);
+
+        writer.startThread(juce::Thread::Priority::high);
+        reader.startThread(juce::Thread::Priority::high);
+
+        if (control != nullptr)
+            control->startThread(juce::Thread::Priority::low);
+
+        juce::AudioBuffer<float> buffer(options.numChannels, options.blockSize);
+        juce::MidiBuffer midi;
+
+        while (auto* in = inputQueue.waitForFull())
+        {
+            auto numFrames = in->numBytes / frameBytes;
+            juce::AudioBuffer<float> block(buffer.getArrayOfWritePointers(), options.numChannels, numFrames);
+
+            deinterleavePcm(options.format, in->bytes, block, numFrames);
+            inputQueue.release();
+
+            if (control != nullptr)
+                control->applyPending();
+
+            processor.processBlock(block, midi);
+            midi.clear();
+
+            auto* out = outputQueue.waitForEmpty();
+
+            //the writer closes its queue when whatever reads our output has gone
+            if (out == nullptr)
+                break;
+
+            interleavePcm(options.format, block, out->bytes, numFrames);
+            out->numBytes = numFrames * frameBytes;
+            outputQueue.publish();
+        }
+
+        reader.signalThreadShouldExit();
+        inputQueue.close();
+        outputQueue.close();
+        writer.waitForThreadToExit(-1);
+
+        processor.releaseResources();
+        return writer.hasFailed() ? 1 : 0;
+    }
+}
+
+int main(int argc, char* argv[])
+{
+    //a downstream process exiting should end the stream, not kill it mid-write
+    std::signal(SIGPIPE, SIG_IGN);
+
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    if (args.containsOption("--help|-h"))
+    {
+        std::cerr << usage;
+        return 0;
+    }
+
+    return juce::ConsoleApplication::invokeCatchingFailures([&args]
+    {
+        return stream(parseOptions(args));
+    });
+}
@@ -9,56 +9,327 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
 
+namespace
+{
+constexpr int sectionWidth = 180;
+constexpr int headerHeight = 28;
+constexpr int orderBarHeight = 36;
+constexpr int margin = 8;
+constexpr int memoryLabelWidth = 110;
+constexpr int qualityButtonWidth = 80;
+constexpr int qualityLabelWidth = 190;
+constexpr int monoPathBoxWidth = 72;
+constexpr int sectionRows = 4;
+}
+
 //==============================================================================
 Project13_NewAudioProcessorEditor::Project13_NewAudioProcessorEditor (Project13_NewAudioProcessor& p)
     : AudioProcessorEditor (&p), audioProcessor (p)
 {
-    // Make sure that before the constructor has finished, you've set the
-    // editor's size to whatever you need it to be.
-  dspOrderButton.onClick = [this]()
-  {
-    juce::Random r;
-    Project13_NewAudioProcessor::DSP_Order dspOrder;
+    setOpaque(true);
 
-      auto range = juce::Range<int>(static_cast<int>(Project13_NewAudioProcessor::DSP_Option::Phase),static_cast<int>(Project13_NewAudioProcessor::DSP_Option::END_OF_LIST));
+    multibandModeBox.addItemList(p.multibandMode->choices, 1);
+    multibandModeAttachment = std::make_unique<juce::ComboBoxParameterAttachment>(*p.multibandMode, multibandModeBox);
+    addAndMakeVisible(multibandModeBox);
 
-      for(auto& v : dspOrder)
-      {
-        auto entry = r.nextInt(range);
+    monoPathBox.addItemList(p.monoPath->choices, 1);
+    monoPathAttachment = std::make_unique<juce::ComboBoxParameterAttachment>(*p.monoPath, monoPathBox);
+    monoPathBox.setTooltip("Mono fast path: run the chain once when both sides are identical");
+    addAndMakeVisible(monoPathBox);
 
-        v = static_cast<Project13_NewAudioProcessor::DSP_Option>(entry);
-      }
+    for (size_t i = 0; i < crossoverSliders.size(); ++i)
+    {
+        auto& slider = crossoverSliders[i];
+        slider.setSliderStyle(juce::Slider::LinearHorizontal);
+        slider.setTextBoxStyle(juce::Slider::TextBoxRight, true, 64, headerHeight - 6);
+        crossoverAttachments.add(new juce::SliderParameterAttachment(*p.crossoverFreqHz[i], slider, nullptr));
+        addAndMakeVisible(slider);
+    }
 
-      DBG( juce::Base64::toBase64(dspOrder.data(),dspOrder.size()));
-      jassertfalse;
+    for (size_t b = 0; b < bandButtons.size(); ++b)
+    {
+        auto& button = bandButtons[b];
+        button.setButtonText("Band " + juce::String(b + 1));
+        button.setClickingTogglesState(true);
+        button.setRadioGroupId(1);
+        button.onClick = [this, b]()
+        {
+            if (bandButtons[b].getToggleState() && b != selectedBand)
+                showBand(b);
+        };
+        addAndMakeVisible(button);
+    }
 
-      audioProcessor.dspOrderFifo.push(dspOrder);
+    dspOrderBar.onOrderChanged = [this](const Project13_NewAudioProcessor::DSP_Order& newOrder)
+    {
+        audioProcessor.requestDSPOrder(selectedBand, newOrder);
+        resized();
     };
-  addAndMakeVisible(dspOrderButton);  
-  setSize (400, 300);
+    addAndMakeVisible(dspOrderBar);
+    addAndMakeVisible(morphBar);
+
+    memoryLabel.setJustificationType(juce::Justification::centredRight);
+    memoryLabel.setColour(juce::Label::textColourId, juce::Colours::white.withAlpha(0.6f));
+    memoryLabel.setTooltip("Estimated memory held by this instance's DSP");
+    addAndMakeVisible(memoryLabel);
+
+    adaptiveQualityAttachment = std::make_unique<juce::ButtonParameterAttachment>(*p.adaptiveQuality, adaptiveQualityButton);
+    adaptiveQualityButton.setTooltip("Lower the quality while the CPU can't keep up, and raise it again once it can");
+    addAndMakeVisible(adaptiveQualityButton);
+
+    qualityLabel.setColour(juce::Label::textColourId, juce::Colours::white.withAlpha(0.6f));
+    addAndMakeVisible(qualityLabel);
+
+    audioProcessor.dspOrderBroadcaster.addChangeListener(this);
+    audioProcessor.dspMemoryBroadcaster.addChangeListener(this);
+    audioProcessor.qualityBroadcaster.addChangeListener(this);
+    refreshMemoryLabel();
+    refreshQualityLabel();
 
+    bandButtons[0].setToggleState(true, juce::dontSendNotification);
+    showBand(0);
 
-    
+    auto numSlots = static_cast<int>(std::tuple_size<Project13_NewAudioProcessor::DSP_Order>::value);
+    auto sectionHeight = EffectSection::titleHeight + 12
+                       + sectionRows * (EffectSection::knobSize + EffectSection::captionHeight * 2);
+
+    setSize (numSlots * sectionWidth + (numSlots + 1) * margin,
+             2 * headerHeight + orderBarHeight + sectionHeight + 5 * margin);
 }
 
 Project13_NewAudioProcessorEditor::~Project13_NewAudioProcessorEditor()
 {
+    audioProcessor.dspOrderBroadcaster.removeChangeListener(this);
+    audioProcessor.dspMemoryBroadcaster.removeChangeListener(this);
+    audioProcessor.qualityBroadcaster.removeChangeListener(this);
+}
+
+void Project13_NewAudioProcessorEditor::showBand(size_t band)
+{
+    selectedBand = band;
+    auto& cp = audioProcessor.chainParams[band];
+
+    phaserSection = std::make_unique<EffectSection>("Phaser",
+        std::vector<EffectSection::Control>
+        {
+            { cp.phaserRateHz, "Rate" },
+            { cp.phaserDepthPercent, "Depth" },
+            { cp.phaserCenterFreqHz, "Center" },
+            { cp.phaserFeedbackPercent, "Feedback" },
+            { cp.phaserMixPercent, "Mix" },
+        },
+        *cp.phaserBypass, cp.phaserRateHz);
+
+    chorusSection = std::make_unique<EffectSection>("Chorus",
+        std::vector<EffectSection::Control>
+        {
+            { cp.chorusRateHz, "Rate" },
+            { cp.chorusDepthPercent, "Depth" },
+            { cp.chorusCenterDelayMs, "Delay" },
+            { cp.chorusFeedbackPercent, "Feedback" },
+            { cp.chorusMixPercent, "Mix" },
+        },
+        *cp.chorusBypass, cp.chorusRateHz);
+
+    overdriveSection = std::make_unique<EffectSection>("Overdrive",
+        std::vector<EffectSection::Control>
+        {
+            { cp.overdriveSaturation, "Saturation" },
+        },
+        *cp.overdriveBypass);
+
+    ladderFilterSection = std::make_unique<EffectSection>("Ladder Filter",
+        std::vector<EffectSection::Control>
+        {
+            { cp.ladderFilterMode, "Mode" },
+            { cp.ladderFilterCutoffHz, "Cutoff" },
+            { cp.ladderFilterResonance, "Resonance" },
+            { cp.ladderFilterDrive, "Drive" },
+        },
+        *cp.ladderFilterBypass);
+
+    generalFilterSection = std::make_unique<EffectSection>("General Filter",
+        std::vector<EffectSection::Control>
+        {
+            { cp.generalFilterMode, "Mode" },
+            { cp.generalilterFreqHz, "Freq" },
+            { cp.generalilterQuality, "Q" },
+            { cp.generalilterGain, "Gain" },
+            { cp.generalFilterTopology, "Topology" },
+        },
+        *cp.generalFilterBypass);
+
+    delaySection = std::make_unique<EffectSection>("Delay",
+        std::vector<EffectSection::Control>
+        {
+            { cp.delayTimeMs, "Time" },
+            { cp.delayNoteDivision, "Note" },
+            { cp.delaySync, "Sync" },
+            { cp.delayPingPong, "Ping Pong" },
+            { cp.delayFeedbackPercent, "Feedback" },
+            { cp.delayMixPercent, "Mix" },
+            { cp.delayLowCutHz, "Low Cut" },
+            { cp.delayHighCutHz, "High Cut" },
+        },
+        *cp.delayBypass);
+
+    convolutionSection = std::make_unique<EffectSection>("Convolution",
+        std::vector<EffectSection::Control>
+        {
+            { cp.convolutionMix, "Mix" },
+            { nullptr, "Impulse", [this]() { chooseImpulseResponse(); } },
+        },
+        *cp.convolutionBypass);
+
+    for (auto* s : { phaserSection.get(), chorusSection.get(), overdriveSection.get(),
+                     ladderFilterSection.get(), generalFilterSection.get(), delaySection.get(),
+                     convolutionSection.get() })
+        addAndMakeVisible(s);
+
+    dspOrderBar.setOrder(audioProcessor.getRequestedDSPOrder(band));
+    resized();
+}
+
+void Project13_NewAudioProcessorEditor::changeListenerCallback(juce::ChangeBroadcaster* source)
+{
+    if (source == &audioProcessor.dspMemoryBroadcaster)
+    {
+        refreshMemoryLabel();
+        return;
+    }
+
+    if (source == &audioProcessor.qualityBroadcaster)
+    {
+        refreshQualityLabel();
+        return;
+    }
+
+    dspOrderBar.setOrder(audioProcessor.getRequestedDSPOrder(selectedBand));
+    resized();
+}
+
+void Project13_NewAudioProcessorEditor::refreshMemoryLabel()
+{
+    auto bytes = static_cast<juce::int64>(audioProcessor.getDSPMemoryBytes());
+    memoryLabel.setText("DSP " + juce::File::descriptionOfSizeInBytes(bytes), juce::dontSendNotification);
+}
+
+void Project13_NewAudioProcessorEditor::refreshQualityLabel()
+{
+    auto level = audioProcessor.getQualityLevel();
+    auto dropped = audioProcessor.getNumDroppedTailFrames();
+    auto text = "Quality " + QualityGovernor::getLevelName(level);
+
+    //a convolution tail that missed its deadline is an audible gap, so it is shown rather than hidden
+    if (dropped > 0)
+        text << ", " << dropped << " tail dropouts";
+
+    qualityLabel.setText(text, juce::dontSendNotification);
+    qualityLabel.setColour(juce::Label::textColourId, level == QualityGovernor::Level::Full && dropped == 0
+                                                          ? juce::Colours::white.withAlpha(0.6f)
+                                                          : juce::Colours::orange);
+}
+
+void Project13_NewAudioProcessorEditor::chooseImpulseResponse()
+{
+    impulseResponseChooser = std::make_unique<juce::FileChooser>("Load an impulse response",
+                                                                 audioProcessor.getImpulseResponseFile(),
+                                                                 "*.wav;*.aif;*.aiff;*.flac");
+
+    //every band shares the one impulse response, so the result goes straight to the processor
+    impulseResponseChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                                        [this](const juce::FileChooser& chooser)
+    {
+        auto file = chooser.getResult();
+
+        if (file.existsAsFile())
+            audioProcessor.loadImpulseResponse(file);
+    });
+}
+
+EffectSection* Project13_NewAudioProcessorEditor::getSection(Project13_NewAudioProcessor::DSP_Option option)
+{
+    using DSP_Option = Project13_NewAudioProcessor::DSP_Option;
+
+    switch (option)
+    {
+        case DSP_Option::Phase: return phaserSection.get();
+        case DSP_Option::Chorus: return chorusSection.get();
+        case DSP_Option::Overdrive: return overdriveSection.get();
+        case DSP_Option::LadderFilter: return ladderFilterSection.get();
+        case DSP_Option::GeneralFilter: return generalFilterSection.get();
+        case DSP_Option::Delay: return delaySection.get();
+        case DSP_Option::Convolution: return convolutionSection.get();
+        case DSP_Option::END_OF_LIST: break;
+    }
+
+    return nullptr;
 }
 
 //==============================================================================
 void Project13_NewAudioProcessorEditor::paint (juce::Graphics& g)
 {
     // (Our component is opaque, so we must completely fill the background with a solid colour)
-    g.fillAll (getLookAndFeel().findColour (juce::ResizableWindow::backgroundColourId));
-
-    g.setColour (juce::Colours::white);
-    g.setFont (15.0f);
-    g.drawFittedText ("Hello World!", getLocalBounds(), juce::Justification::centred, 1);
+    g.fillAll (juce::Colour(0xff181b1f));
 }
 
 void Project13_NewAudioProcessorEditor::resized()
 {
-     // This is generally where you'll want to lay out the positions of any
-    // subcomponents in your editor..
-   dspOrderButton.setBounds(getLocalBounds().reduced(100));   
+    auto bounds = getLocalBounds().reduced(margin);
+
+    auto header = bounds.removeFromTop(headerHeight);
+    multibandModeBox.setBounds(header.removeFromLeft(100));
+    header.removeFromLeft(margin);
+    monoPathBox.setBounds(header.removeFromLeft(monoPathBoxWidth));
+    header.removeFromLeft(margin);
+
+    for (auto& button : bandButtons)
+        button.setBounds(header.removeFromLeft(64));
+
+    header.removeFromLeft(margin);
+    auto crossoverWidth = header.getWidth() / static_cast<int>(crossoverSliders.size());
+
+    for (auto& slider : crossoverSliders)
+        slider.setBounds(header.removeFromLeft(crossoverWidth));
+
+    bounds.removeFromTop(margin);
+    auto morphRow = bounds.removeFromTop(headerHeight);
+    memoryLabel.setBounds(morphRow.removeFromRight(memoryLabelWidth));
+    qualityLabel.setBounds(morphRow.removeFromRight(qualityLabelWidth));
+    adaptiveQualityButton.setBounds(morphRow.removeFromRight(qualityButtonWidth));
+    morphBar.setBounds(morphRow);
+    bounds.removeFromTop(margin);
+    dspOrderBar.setBounds(bounds.removeFromTop(orderBarHeight));
+    bounds.removeFromTop(margin);
+
+    if (phaserSection == nullptr)
+        return;
+
+    //sections follow the chain order so the panels read left to right like the signal does
+    auto order = dspOrderBar.getOrder();
+    std::vector<EffectSection*> placed;
+
+    for (auto option : order)
+    {
+        auto* section = getSection(option);
+
+        if (section == nullptr || std::find(placed.begin(), placed.end(), section) != placed.end())
+            continue;
+
+        section->setBounds(bounds.removeFromLeft(sectionWidth));
+        bounds.removeFromLeft(margin);
+        placed.push_back(section);
+    }
+
+    //anything missing from a malformed saved order still gets a slot
+    for (auto* s : { phaserSection.get(), chorusSection.get(), overdriveSection.get(),
+                     ladderFilterSection.get(), generalFilterSection.get(), delaySection.get(),
+                     convolutionSection.get() })
+    {
+        if (std::find(placed.begin(), placed.end(), s) == placed.end())
+        {
+            s->setBounds(bounds.removeFromLeft(sectionWidth));
+            bounds.removeFromLeft(margin);
+        }
+    }
 }
@@ -10,11 +10,15 @@
 
 #include <JuceHeader.h>
 #include "PluginProcessor.h"
+#include "GUI/DSPOrderBar.h"
+#include "GUI/EffectSection.h"
+#include "GUI/MorphBar.h"
 
 //==============================================================================
 /**
 */
-class Project13_NewAudioProcessorEditor  : public juce::AudioProcessorEditor
+class Project13_NewAudioProcessorEditor  : public juce::AudioProcessorEditor,
+                                           private juce::ChangeListener
 {
 public:
     Project13_NewAudioProcessorEditor (Project13_NewAudioProcessor&);
@@ -25,10 +29,39 @@ public:
     void resized() override;
 
 private:
+    void changeListenerCallback(juce::ChangeBroadcaster*) override;
+    EffectSection* getSection(Project13_NewAudioProcessor::DSP_Option option);
+
+    /** rebuilds the section panels so they are attached to the selected band's parameters */
+    void showBand(size_t band);
+    void refreshMemoryLabel();
+    void refreshQualityLabel();
+    void chooseImpulseResponse();
+
     // This reference is provided as a quick way for your editor to
     // access the processor object that created it.
     Project13_NewAudioProcessor& audioProcessor;
-    
-    juce::TextButton dspOrderButton{"dso order"};
+
+    juce::ComboBox multibandModeBox;
+    std::unique_ptr<juce::ComboBoxParameterAttachment> multibandModeAttachment;
+    juce::ComboBox monoPathBox;
+    std::unique_ptr<juce::ComboBoxParameterAttachment> monoPathAttachment;
+
+    std::array<juce::Slider, Project13_NewAudioProcessor::maxBands - 1> crossoverSliders;
+    juce::OwnedArray<juce::SliderParameterAttachment> crossoverAttachments;
+
+    std::array<juce::TextButton, Project13_NewAudioProcessor::maxBands> bandButtons;
+    size_t selectedBand = 0;
+
+    MorphBar morphBar { audioProcessor };
+    juce::Label memoryLabel;
+    juce::ToggleButton adaptiveQualityButton { "Adaptive" };
+    std::unique_ptr<juce::ButtonParameterAttachment> adaptiveQualityAttachment;
+    juce::Label qualityLabel;
+    DSPOrderBar dspOrderBar;
+
+    std::unique_ptr<EffectSection> phaserSection, chorusSection, overdriveSection, ladderFilterSection, generalFilterSection, delaySection, convolutionSection;
+    std::unique_ptr<juce::FileChooser> impulseResponseChooser;
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Project13_NewAudioProcessorEditor)
 };
@@ -13,6 +13,7 @@
 #include "juce_core/system/juce_PlatformDefs.h"
 #include "juce_dsp/juce_dsp.h"
 #include <array>
+#include <cstring>
 #include <memory>
 
 auto getPhaserRateName() { return juce::String("Phaser ratehz"); }
@@ -67,6 +68,99 @@ auto getGeneralFilterFreqName() { return juce::String("general filter frequency
 auto getGeneralFilterQuatlityName() { return juce::String("genrel filter quality"); }
 auto getGeneralFilterGainName() { return juce::String("general filter gain"); }
 auto getGeneralFilterBypassName() {return juce::String("GeneralFilter Bypass");}
+auto getGeneralFilterTopologyName() { return juce::String("General Filter Topology"); }
+
+auto getGeneralFilterTopologyChoices()
+{
+    return juce::StringArray
+    {
+        "Biquad",
+        "SVF",
+    };
+}
+
+auto getDelayTimeName() { return juce::String("Delay Time ms"); }
+auto getDelayFeedbackName() { return juce::String("Delay Feedback percent"); }
+auto getDelayMixName() { return juce::String("Delay Mix"); }
+auto getDelayLowCutName() { return juce::String("Delay Low Cut Hz"); }
+auto getDelayHighCutName() { return juce::String("Delay High Cut Hz"); }
+auto getDelaySyncName() { return juce::String("Delay Sync"); }
+auto getDelayNoteName() { return juce::String("Delay Note"); }
+auto getDelayPingPongName() { return juce::String("Delay Ping Pong"); }
+auto getDelayBypassName() { return juce::String("Delay Bypass"); }
+
+auto getConvolutionMixName() { return juce::String("Convolution Mix"); }
+auto getConvolutionBypassName() { return juce::String("Convolution Bypass"); }
+
+auto getMultibandModeName() { return juce::String("Multiband Mode"); }
+auto getCrossover1Name() { return juce::String("Crossover 1 Hz"); }
+auto getCrossover2Name() { return juce::String("Crossover 2 Hz"); }
+auto getCrossover3Name() { return juce::String("Crossover 3 Hz"); }
+
+auto getMorphPositionName() { return juce::String("Morph Position"); }
+auto getMorphEnabledName() { return juce::String("Morph Enabled"); }
+auto getAdaptiveQualityName() { return juce::String("Adaptive Quality"); }
+auto getMonoPathName() { return juce::String("Mono Fast Path"); }
+
+auto getMorphSnapshotPropertyName(size_t slot)
+{
+    return "morphSnapshot" + juce::String(slot + 1);
+}
+
+auto getMultibandChoices()
+{
+    return juce::StringArray
+    {
+        "Off",
+        "2 Bands",
+        "3 Bands",
+        "4 Bands",
+    };
+}
+
+auto getMonoPathChoices()
+{
+    return juce::StringArray
+    {
+        "Off",
+        "Auto",
+    };
+}
+
+//band 0 keeps the original parameter IDs so existing sessions still load
+auto getBandPrefix(size_t band)
+{
+    return band == 0 ? juce::String() : "Band " + juce::String(band + 1) + " ";
+}
+
+auto getImpulseResponsePropertyName() { return juce::String("impulseResponse"); }
+
+#if PROJECT13_TRACING
+//literals, since the trace only keeps the pointer
+const char* getStageTraceName(Project13_NewAudioProcessor::DSP_Option option)
+{
+    using DSP_Option = Project13_NewAudioProcessor::DSP_Option;
+
+    switch (option)
+    {
+        case DSP_Option::Phase: return "Phaser";
+        case DSP_Option::Chorus: return "Chorus";
+        case DSP_Option::Overdrive: return "Overdrive";
+        case DSP_Option::LadderFilter: return "Ladder Filter";
+        case DSP_Option::GeneralFilter: return "General Filter";
+        case DSP_Option::Delay: return "Delay";
+        case DSP_Option::Convolution: return "Convolution";
+        case DSP_Option::END_OF_LIST: break;
+    }
+
+    return "Unknown stage";
+}
+#endif
+
+auto getDSPOrderPropertyName(size_t band)
+{
+    return band == 0 ? juce::String("dspOrder") : "dspOrder" + juce::String(band + 1);
+}
 //==============================================================================
 Project13_NewAudioProcessor::Project13_NewAudioProcessor()
 #ifndef JucePlugin_PreferredChannelConfigurations
@@ -80,38 +174,202 @@ Project13_NewAudioProcessor::Project13_NewAudioProcessor()
                        )
 #endif
 {
-  dspOrder = 
-  {{
-      DSP_Option::Phase,
-      DSP_Option::Chorus,
-      DSP_Option::Overdrive,
-      DSP_Option::LadderFilter
+  for (size_t band = 0; band < maxBands; ++band)
+  {
+    cacheChainParams(chainParams[band], getBandPrefix(band));
+
+    bands[band].dspOrder =
+    {{
+        DSP_Option::Phase,
+        DSP_Option::Chorus,
+        DSP_Option::Overdrive,
+        DSP_Option::LadderFilter,
+        DSP_Option::GeneralFilter,
+        DSP_Option::Delay,
+        DSP_Option::Convolution
     }};
+    requestedDSPOrders[band] = bands[band].dspOrder;
+  }
+
+  auto multibandChoiceParams = std::array
+  {
+    &multibandMode,
+    &monoPath,
+  };
+  auto multibandChoiceNameFuncs = std::array
+  {
+    &getMultibandModeName,
+    &getMonoPathName,
+  };
+  initCachedParams<juce::AudioParameterChoice*>(multibandChoiceParams, multibandChoiceNameFuncs);
+
+  auto crossoverParams = std::array
+  {
+    &crossoverFreqHz[0],
+    &crossoverFreqHz[1],
+    &crossoverFreqHz[2],
+  };
+  auto crossoverNameFuncs = std::array
+  {
+    &getCrossover1Name,
+    &getCrossover2Name,
+    &getCrossover3Name,
+  };
+  initCachedParams<juce::AudioParameterFloat*>(crossoverParams, crossoverNameFuncs);
+
+  auto morphFloatParams = std::array
+  {
+    &morphPosition,
+  };
+  auto morphFloatNameFuncs = std::array
+  {
+    &getMorphPositionName,
+  };
+  initCachedParams<juce::AudioParameterFloat*>(morphFloatParams, morphFloatNameFuncs);
+
+  auto morphBoolParams = std::array
+  {
+    &morphEnabled,
+  };
+  auto morphBoolNameFuncs = std::array
+  {
+    &getMorphEnabledName,
+  };
+  initCachedParams<juce::AudioParameterBool*>(morphBoolParams, morphBoolNameFuncs);
+
+  auto qualityParams = std::array
+  {
+    &adaptiveQuality,
+  };
+  auto qualityNameFuncs = std::array
+  {
+    &getAdaptiveQualityName,
+  };
+  initCachedParams<juce::AudioParameterBool*>(qualityParams, qualityNameFuncs);
+
+  //lay out the packed arrays and point each band at its slice
+  for (size_t band = 0; band < maxBands; ++band)
+  {
+    auto floats = chainParams[band].getFloatParams();
+    auto discretes = chainParams[band].getDiscreteParams();
+
+    std::copy(floats.begin(), floats.end(), packedFloatParams.begin() + static_cast<std::ptrdiff_t>(band * numChainFloats));
+    std::copy(discretes.begin(), discretes.end(), packedDiscreteParams.begin() + static_cast<std::ptrdiff_t>(band * numChainDiscretes));
+
+    bands[band].values.floats = packedFloats.data() + band * numChainFloats;
+    bands[band].values.discretes = packedDiscretes.data() + band * numChainDiscretes;
+  }
+
+  std::copy(crossoverFreqHz.begin(), crossoverFreqHz.end(), packedFloatParams.begin() + static_cast<std::ptrdiff_t>(maxBands * numChainFloats));
+  packedDiscreteParams.back() = multibandMode;
+
+  readParamValues(packedFloats.data(), packedDiscretes.data());
+
+  preparationThread->add(&stagePreparer);
+}
+
+std::array<juce::AudioParameterFloat*, Project13_NewAudioProcessor::numChainFloats>
+Project13_NewAudioProcessor::ChainParameters::getFloatParams() const
+{
+    return
+    {{
+        phaserRateHz,
+        phaserCenterFreqHz,
+        phaserDepthPercent,
+        phaserFeedbackPercent,
+        phaserMixPercent,
+
+        chorusRateHz,
+        chorusDepthPercent,
+        chorusCenterDelayMs,
+        chorusFeedbackPercent,
+        chorusMixPercent,
+
+        overdriveSaturation,
+
+        ladderFilterCutoffHz,
+        ladderFilterResonance,
+        ladderFilterDrive,
+
+        generalilterFreqHz,
+        generalilterQuality,
+        generalilterGain,
+
+        delayTimeMs,
+        delayFeedbackPercent,
+        delayMixPercent,
+        delayLowCutHz,
+        delayHighCutHz,
+
+        convolutionMix,
+    }};
+}
+
+std::array<juce::RangedAudioParameter*, Project13_NewAudioProcessor::numChainDiscretes>
+Project13_NewAudioProcessor::ChainParameters::getDiscreteParams() const
+{
+    return
+    {{
+        phaserBypass,
+        chorusBypass,
+        overdriveBypass,
+        ladderFilterMode,
+        ladderFilterBypass,
+        generalFilterMode,
+        generalFilterBypass,
+        generalFilterTopology,
+        delaySync,
+        delayNoteDivision,
+        delayPingPong,
+        delayBypass,
+        convolutionBypass,
+    }};
+}
+
+void Project13_NewAudioProcessor::readParamValues(float* floats, float* discretes) const
+{
+    for (size_t i = 0; i < numPackedFloats; ++i)
+        floats[i] = packedFloatParams[i]->get();
+
+    //choice index or 0/1
+    for (size_t i = 0; i < numPackedDiscretes; ++i)
+        discretes[i] = packedDiscreteParams[i]->convertFrom0to1(packedDiscreteParams[i]->getValue());
+}
+
+void Project13_NewAudioProcessor::cacheChainParams(ChainParameters& cp, const juce::String& prefix)
+{
     auto floatParams = std::array
     {
-        &phaserRateHz,
-        &phaserCenterFreqHz,
-        &phaserDepthPercent,
-        &phaserFeedbackPercent,
-        &phaserMixPercent,
+        &cp.phaserRateHz,
+        &cp.phaserCenterFreqHz,
+        &cp.phaserDepthPercent,
+        &cp.phaserFeedbackPercent,
+        &cp.phaserMixPercent,
 
-        &chorusRateHz,
-        &chorusDepthPercent,
-        &chorusCenterDelayMs,
-        &chorusFeedbackPercent,
-        &chorusMixPercent,
+        &cp.chorusRateHz,
+        &cp.chorusDepthPercent,
+        &cp.chorusCenterDelayMs,
+        &cp.chorusFeedbackPercent,
+        &cp.chorusMixPercent,
 
-        &overdriveSaturation,
+        &cp.overdriveSaturation,
 
-         &ladderFilterCutoffHz,
-         &ladderFilterResonance,
-         &ladderFilterDrive,
+         &cp.ladderFilterCutoffHz,
+         &cp.ladderFilterResonance,
+         &cp.ladderFilterDrive,
 
           
-          &generalilterFreqHz,
-          &generalilterQuality,
-          &generalilterGain,
+          &cp.generalilterFreqHz,
+          &cp.generalilterQuality,
+          &cp.generalilterGain,
+
+        &cp.delayTimeMs,
+        &cp.delayFeedbackPercent,
+        &cp.delayMixPercent,
+        &cp.delayLowCutHz,
+        &cp.delayHighCutHz,
 
+        &cp.convolutionMix,
     };
 
     auto floatNameFuncs = std::array
@@ -134,33 +392,47 @@ Project13_NewAudioProcessor::Project13_NewAudioProcessor()
         &getLadderFilterResonanceName,
         &getLadderFilterDriveName,
 
-        &getLadderFilterCutoffName,
-        &getLadderFilterResonanceName,
-        &getLadderFilterDriveName,
- 
+        &getGeneralFilterFreqName,
+        &getGeneralFilterQuatlityName,
+        &getGeneralFilterGainName,
+
+        &getDelayTimeName,
+        &getDelayFeedbackName,
+        &getDelayMixName,
+        &getDelayLowCutName,
+        &getDelayHighCutName,
 
+        &getConvolutionMixName,
     };
-    initCachedParams<juce::AudioParameterFloat *>(floatParams, floatNameFuncs);  
+    initCachedParams<juce::AudioParameterFloat *>(floatParams, floatNameFuncs, prefix);  
     auto choiceParams = std::array
     {
-        &ladderFilterMode,
-        &generalFilterMode,
+        &cp.ladderFilterMode,
+        &cp.generalFilterMode,
+        &cp.generalFilterTopology,
+        &cp.delayNoteDivision,
     };
 
     auto choiceNameFuncs = std::array
     {
         &getLadderFilterModeName,
         &getGeneralFilterModeName,
+        &getGeneralFilterTopologyName,
+        &getDelayNoteName,
     };
 
-    initCachedParams<juce::AudioParameterChoice*>(choiceParams,choiceNameFuncs);
+    initCachedParams<juce::AudioParameterChoice*>(choiceParams, choiceNameFuncs, prefix);
   auto bypassParams = std::array
   {
-    &phaserBypass,
-    &chorusBypass,
-    &overdriveBypass,
-    &ladderFilterBypass,
-    &generalFilterBypass,
+    &cp.phaserBypass,
+    &cp.chorusBypass,
+    &cp.overdriveBypass,
+    &cp.ladderFilterBypass,
+    &cp.generalFilterBypass,
+    &cp.delaySync,
+    &cp.delayPingPong,
+    &cp.delayBypass,
+    &cp.convolutionBypass,
                        };
   auto bypassNameFuncs = std::array
                        {
@@ -169,12 +441,18 @@ Project13_NewAudioProcessor::Project13_NewAudioProcessor()
                        &getOverdriveBypassName,
                        &getLadderFilterBypassName,
                        &getGeneralFilterBypassName,
+                       &getDelaySyncName,
+                       &getDelayPingPongName,
+                       &getDelayBypassName,
+                       &getConvolutionBypassName,
                        };
-  initCachedParams<juce::AudioParameterBool*>(bypassParams, bypassNameFuncs);
+  initCachedParams<juce::AudioParameterBool*>(bypassParams, bypassNameFuncs, prefix);
 }
 
 Project13_NewAudioProcessor::~Project13_NewAudioProcessor()
 {
+  //waits for a preparation pass that is already running
+  preparationThread->remove(&stagePreparer);
 }
 
 //==============================================================================
@@ -245,40 +523,616 @@ void Project13_NewAudioProcessor::prepareToPlay (double sampleRate, int samplesP
     juce::dsp::ProcessSpec spec;
     spec.sampleRate= sampleRate;
     spec.maximumBlockSize = samplesPerBlock;
-    spec.numChannels =1;
+    //every stage takes both sides of its band
+    spec.numChannels = 2;
+
+  for (auto& band : bands)
+  {
+    band.setSampleRate(sampleRate, samplesPerBlock);
+  }
+
+  {
+    const juce::ScopedLock sl(preparationLock);
+    stageSpec = spec;
+
+    for (auto& band : bands)
+      band.unprepare();
+
+    //whatever is switched on right now is prepared here, so playback never starts with stages missing
+    readParamValues(packedFloats.data(), packedDiscretes.data());
+    prepareActiveStages();
+  }
+
+  //the crossovers run on every channel of the block at once
+  spec.numChannels = static_cast<juce::uint32>(juce::jmax(1, getTotalNumInputChannels()));
+  bandSplitter.prepare(spec);
+  preparedBlockSize = samplesPerBlock;
+
+  //the finest step there is, over the largest chunk processMultiband hands the bands
+  morphPositions.assign(static_cast<size_t>(samplesPerBlock / morphSubBlockSize + 1), 0.f);
 
-  leftChannel.prepare(spec);
-  rightChannel.prepare(spec);
+  smoothedMorphPosition.reset(sampleRate, 0.05);
+  smoothedMorphPosition.setCurrentAndTargetValue(morphPosition->get());
 
+  //nothing is pulling while we're stopped, so install the latest set directly rather than trust a queue that may have filled up
+  morphSnapshotQueue.pull([](std::unique_ptr<Morpher::SnapshotSet>&) {});
+  auto snapshots = std::make_unique<Morpher::SnapshotSet>(requestedMorphSnapshots);
+  morpher.setSnapshots(snapshots);
+
+  qualityGovernor.prepare(sampleRate);
+
+  //the convolution engines are built for the new sample rate on the preparation thread
+  preparationThread->requestPass();
+  dspMemoryBroadcaster.sendChangeMessage();
 }
-  
 
-  void Project13_NewAudioProcessor::MonoChannelDSP::prepare(const juce::dsp::ProcessSpec& spec)
-                       {
-  
-    jassert(spec.numChannels == 1);
-  std::vector<juce::dsp::ProcessorBase*> dsp
-  {
-    &phaser,
-    &chorus,
-    &overdrive,
-    &ladderFilter,
-    &generalFilter
-  };
+void Project13_NewAudioProcessor::prepareActiveStages()
+{
+  const juce::ScopedLock sl(preparationLock);
+  auto numBands = getNumActiveBands();
 
-  for(auto p : dsp)
+  for (size_t b = 0; b < numBands; ++b)
   {
-    p->prepare(spec);
-    p->reset();
+    for (size_t i = 0; i < static_cast<size_t>(DSP_Option::END_OF_LIST); ++i)
+    {
+      auto option = static_cast<DSP_Option>(i);
+
+      if (! bands[b].isBypassed(option))
+        bands[b].prepareStage(option, stageSpec);
+    }
+
+    if (numBands > 1 && ! bands[b].bufferReady.load(std::memory_order_acquire))
+      bands[b].prepareBuffer(static_cast<int>(stageSpec.maximumBlockSize));
   }
+}
+
+bool Project13_NewAudioProcessor::hasUnpreparedActiveStages()
+{
+  auto numBands = getNumActiveBands();
+
+  for (size_t b = 0; b < numBands; ++b)
+  {
+    auto& band = bands[b];
+
+    if (numBands > 1 && ! band.bufferReady.load(std::memory_order_acquire))
+      return true;
+
+    for (size_t i = 0; i < static_cast<size_t>(DSP_Option::END_OF_LIST); ++i)
+    {
+      auto option = static_cast<DSP_Option>(i);
+
+      if (band.isBypassed(option))
+        continue;
+
+      for (auto* stage : band.getStages(option))
+        if (stage != nullptr && ! stage->ready.load(std::memory_order_acquire))
+          return true;
+    }
+  }
+
+  return false;
+}
+
+void Project13_NewAudioProcessor::requestPreparationIfNeeded()
+{
+  auto requested = std::exchange(bufferRequested, false);
+
+  for (auto& band : bands)
+  {
+    //every band is asked, so none of them keeps a stale request
+    requested = band.takeStageRequests() || requested;
+    requested = requested || band.convolution.isOfferWaiting();
+  }
+
+  auto qualityLevel = qualityGovernor.getLevel();
+  auto droppedTailFrames = getNumDroppedTailFrames();
+
+  if (qualityLevel != signalledQualityLevel || droppedTailFrames != signalledDroppedTailFrames)
+  {
+    signalledQualityLevel = qualityLevel;
+    signalledDroppedTailFrames = droppedTailFrames;
+    requested = true;
   }
 
+  if (requested)
+    preparationThread->requestPass();
+}
+
+void Project13_NewAudioProcessor::prepareWantedStages()
+{
+  auto preparedAny = false;
+
+  {
+    const juce::ScopedLock sl(preparationLock);
+
+    if (stageSpec.maximumBlockSize == 0)
+      return;
+
+    for (auto& band : bands)
+    {
+      for (size_t i = 0; i < static_cast<size_t>(DSP_Option::END_OF_LIST); ++i)
+      {
+        auto option = static_cast<DSP_Option>(i);
+
+        if (band.isStageWanted(option))
+        {
+          band.prepareStage(option, stageSpec);
+          preparedAny = true;
+        }
+      }
+
+      if (band.bufferWanted.load(std::memory_order_relaxed) && ! band.bufferReady.load(std::memory_order_acquire))
+      {
+        band.prepareBuffer(static_cast<int>(stageSpec.maximumBlockSize));
+        preparedAny = true;
+      }
+    }
+  }
+
+  buildImpulseResponses();
+
+  if (preparedAny)
+    dspMemoryBroadcaster.sendChangeMessage();
+
+  //the audio thread only stores the level; the editor hears about it from here
+  auto qualityLevel = qualityGovernor.getLevel();
+
+  auto droppedTailFrames = getNumDroppedTailFrames();
+
+  if (qualityLevel != reportedQualityLevel || droppedTailFrames != reportedDroppedTailFrames)
+  {
+    reportedQualityLevel = qualityLevel;
+    reportedDroppedTailFrames = droppedTailFrames;
+    qualityBroadcaster.sendChangeMessage();
+  }
+}
+
+void Project13_NewAudioProcessor::buildImpulseResponses()
+{
+  juce::File file;
+  int generation = 0;
+  double sampleRate = 0.0;
+  std::array<bool, maxBands> outOfDate {};
+
+  {
+    const juce::ScopedLock sl(preparationLock);
+
+    for (size_t b = 0; b < maxBands; ++b)
+    {
+      auto& convolution = bands[b].convolution;
+
+      //an engine the queue was too full to take last pass
+      convolution.retryOffer();
+      outOfDate[b] = convolution.ready.load(std::memory_order_acquire) && convolution.builtGeneration != impulseResponseGeneration;
+    }
+
+    file = impulseResponseFile;
+    generation = impulseResponseGeneration;
+    sampleRate = stageSpec.sampleRate;
+  }
+
+  if (std::find(outOfDate.begin(), outOfDate.end(), true) == outOfDate.end())
+    return;
+
+  //decoding and partitioning a long file takes a while, so it happens outside the lock
+  juce::AudioBuffer<float> ir;
+  double irSampleRate = 0.0;
+
+  if (file.existsAsFile())
+  {
+    juce::AudioFormatManager formats;
+    formats.registerBasicFormats();
+
+    if (std::unique_ptr<juce::AudioFormatReader> reader { formats.createReaderFor(file) })
+    {
+      auto maxSamples = static_cast<juce::int64>(ConvolutionEngine::maxSeconds * reader->sampleRate);
+      auto numSamples = static_cast<int>(juce::jmin(reader->lengthInSamples, maxSamples));
+
+      ir.setSize(static_cast<int>(juce::jmin(2u, reader->numChannels)), numSamples);
+      reader->read(&ir, 0, numSamples, 0, true, true);
+      irSampleRate = reader->sampleRate;
+    }
+  }
+
+  std::array<std::unique_ptr<ConvolutionEngine>, maxBands> engines;
+
+  for (size_t b = 0; b < maxBands; ++b)
+  {
+    if (outOfDate[b])
+      engines[b] = ConvolutionEngine::create(ir, irSampleRate, sampleRate);
+  }
+
+  {
+    const juce::ScopedLock sl(preparationLock);
+
+    //a newer load or a new sample rate means this build is stale; the next pass picks it up
+    if (generation != impulseResponseGeneration || sampleRate != stageSpec.sampleRate)
+      return;
+
+    for (size_t b = 0; b < maxBands; ++b)
+    {
+      auto& convolution = bands[b].convolution;
+
+      if (! outOfDate[b] || ! convolution.ready.load(std::memory_order_acquire))
+        continue;
+
+      //a file that will not decode leaves the current response playing, and is not retried every pass
+      if (engines[b] != nullptr)
+        convolution.offerEngine(std::move(engines[b]));
+
+      convolution.builtGeneration = generation;
+    }
+  }
+
+  dspMemoryBroadcaster.sendChangeMessage();
+}
+
+void Project13_NewAudioProcessor::setTileSize(int samples)
+{
+  tileSize.store(juce::jmax(0, samples), std::memory_order_relaxed);
+}
+
+int Project13_NewAudioProcessor::getMorphSubBlockSize(QualityGovernor::Level level)
+{
+  switch (level)
+  {
+    case QualityGovernor::Level::Full: return morphSubBlockSize;
+    case QualityGovernor::Level::Reduced: return morphSubBlockSize * 4;
+    case QualityGovernor::Level::Minimum: return morphSubBlockSize * 16;
+  }
+
+  return morphSubBlockSize;
+}
+
+int Project13_NewAudioProcessor::getSvfControlInterval(QualityGovernor::Level level)
+{
+  switch (level)
+  {
+    case QualityGovernor::Level::Full: return 8;
+    case QualityGovernor::Level::Reduced: return 32;
+    case QualityGovernor::Level::Minimum: return 64;
+  }
+
+  return 8;
+}
+
+//1 is JUCE's chorus, an LFO value every sample
+int Project13_NewAudioProcessor::getChorusControlInterval(QualityGovernor::Level level)
+{
+  switch (level)
+  {
+    case QualityGovernor::Level::Full: return 1;
+    case QualityGovernor::Level::Reduced: return 8;
+    case QualityGovernor::Level::Minimum: return 32;
+  }
+
+  return 1;
+}
+
+void Project13_NewAudioProcessor::loadImpulseResponse(const juce::File& file)
+{
+  {
+    const juce::ScopedLock sl(preparationLock);
+    impulseResponseFile = file;
+    ++impulseResponseGeneration;
+  }
+
+  preparationThread->requestPass();
+}
+
+juce::int64 Project13_NewAudioProcessor::getNumDroppedTailFrames() const
+{
+  juce::int64 dropped = 0;
+
+  for (const auto& band : bands)
+    dropped += band.convolution.getNumDroppedTailFrames();
+
+  return dropped;
+}
+
+juce::File Project13_NewAudioProcessor::getImpulseResponseFile() const
+{
+  const juce::ScopedLock sl(preparationLock);
+  return impulseResponseFile;
+}
+
+size_t Project13_NewAudioProcessor::getDSPMemoryBytes() const
+{
+  const juce::ScopedLock sl(preparationLock);
+  auto bytes = sizeof(*this);
+
+  for (const auto& band : bands)
+    bytes += band.getHeapBytes(stageSpec);
+
+  return bytes;
+}
+
+bool Project13_NewAudioProcessor::BandChain::isBypassed(DSP_Option option) const
+{
+  switch (option)
+  {
+    case DSP_Option::Phase: return values.isOn(ChainDiscrete::PhaserBypass);
+    case DSP_Option::Chorus: return values.isOn(ChainDiscrete::ChorusBypass);
+    case DSP_Option::Overdrive: return values.isOn(ChainDiscrete::OverdriveBypass);
+    case DSP_Option::LadderFilter: return values.isOn(ChainDiscrete::LadderFilterBypass);
+    case DSP_Option::GeneralFilter: return values.isOn(ChainDiscrete::GeneralFilterBypass);
+    case DSP_Option::Delay: return values.isOn(ChainDiscrete::DelayBypass);
+    case DSP_Option::Convolution: return values.isOn(ChainDiscrete::ConvolutionBypass);
+    case DSP_Option::END_OF_LIST: break;
+  }
+
+  return true;
+}
+
+LazyStage* Project13_NewAudioProcessor::BandChain::getStage(DSP_Option option)
+{
+  switch (option)
+  {
+    case DSP_Option::Phase: return &phaser;
+    case DSP_Option::Chorus: return &chorus;
+    case DSP_Option::Overdrive: return &overdrive;
+    case DSP_Option::LadderFilter: return &ladderFilter;
+    case DSP_Option::GeneralFilter: return usesSvf() ? static_cast<LazyStage*>(&svfFilter) : &generalFilter;
+    case DSP_Option::Delay: return &delay;
+    case DSP_Option::Convolution: return &convolution;
+    case DSP_Option::END_OF_LIST: break;
+  }
+
+  return nullptr;
+}
+
+std::array<LazyStage*, 2> Project13_NewAudioProcessor::BandChain::getStages(DSP_Option option)
+{
+  //both general filter topologies, so switching never has to wait for one
+  if (option == DSP_Option::GeneralFilter)
+    return { &generalFilter, &svfFilter };
+
+  return { getStage(option), nullptr };
+}
+
+bool Project13_NewAudioProcessor::BandChain::usesSvf() const
+{
+  return values.getIndex(ChainDiscrete::GeneralFilterTopology) == 1;
+}
+
+bool Project13_NewAudioProcessor::BandChain::isStageWanted(DSP_Option option)
+{
+  for (auto* stage : getStages(option))
+  {
+    if (stage != nullptr && stage->wanted.load(std::memory_order_relaxed) && ! stage->ready.load(std::memory_order_acquire))
+      return true;
+  }
+
+  return false;
+}
+
+void Project13_NewAudioProcessor::BandChain::prepareStage(DSP_Option option, const juce::dsp::ProcessSpec& spec)
+{
+  for (auto* stage : getStages(option))
+  {
+    if (stage != nullptr && ! stage->ready.load(std::memory_order_acquire))
+      stage->prepareAndReset(spec);
+  }
+}
+
+size_t Project13_NewAudioProcessor::BandChain::getHeapBytes(const juce::dsp::ProcessSpec& spec) const
+{
+  const std::array<const LazyStage*, 8> stages { &phaser, &chorus, &overdrive, &ladderFilter,
+                                                 &generalFilter, &svfFilter, &delay, &convolution };
+  size_t bytes = 0;
+
+  for (auto* stage : stages)
+  {
+    if (stage->ready.load(std::memory_order_acquire))
+      bytes += stage->getHeapBytes(spec);
+  }
+
+  if (bufferReady.load(std::memory_order_acquire))
+    bytes += static_cast<size_t>(buffer.getNumChannels() * buffer.getNumSamples()) * sizeof(float);
+
+  return bytes;
+}
+
+void Project13_NewAudioProcessor::BandChain::reset()
+{
+  //the preparation thread resets a stage as it readies it, and never touches one that is ready
+  for (size_t i = 0; i < static_cast<size_t>(DSP_Option::END_OF_LIST); ++i)
+  {
+    for (auto* stage : getStages(static_cast<DSP_Option>(i)))
+    {
+      if (stage != nullptr && stage->ready.load(std::memory_order_acquire))
+      {
+        stage->reset();
+        stage->rightStale = false;
+      }
+    }
+  }
+}
+
+void Project13_NewAudioProcessor::BandChain::setSampleRate(double newSampleRate, int maximumBlockSize)
+{
+  sampleRate = newSampleRate;
+  lastFilterSettings.fill(-1.f);
+  fadeScratch.setSize(2, maximumBlockSize);
+}
+
+bool Project13_NewAudioProcessor::BandChain::takeStageRequests()
+{
+  return std::exchange(stageRequested, false);
+}
+
+void Project13_NewAudioProcessor::BandChain::prepareBuffer(int numSamples)
+{
+  buffer.setSize(2, numSamples);
+  bufferWanted.store(false, std::memory_order_relaxed);
+  bufferReady.store(true, std::memory_order_release);
+}
+
+void Project13_NewAudioProcessor::BandChain::unprepare()
+{
+  for (size_t i = 0; i < static_cast<size_t>(DSP_Option::END_OF_LIST); ++i)
+    for (auto* stage : getStages(static_cast<DSP_Option>(i)))
+      if (stage != nullptr)
+        stage->unprepare();
+
+  bufferReady.store(false);
+  bufferWanted.store(false);
+}
+
+void Project13_NewAudioProcessor::BandChain::process(juce::dsp::AudioBlock<float> block)
+{
+  PROJECT13_TRACE_SCOPE("Band");
+
+  for (size_t i = 0; i < static_cast<size_t>(DSP_Option::END_OF_LIST); ++i)
+    for (auto* stage : getStages(static_cast<DSP_Option>(i)))
+      if (stage != nullptr)
+        stage->latchReadiness();
+
+  updateDSPFromParams();
+
+  //checked once, at the input; from there on the chain knows which stages kept the sides the same
+  auto numSamples = block.getNumSamples();
+  auto sidesIdentical = monoPathEnabled && block.getNumChannels() > 1
+                     && std::memcmp(block.getChannelPointer(0), block.getChannelPointer(1), numSamples * sizeof(float)) == 0;
+
+  //long blocks run the whole chain one tile at a time, so a tile is still in cache when the next stage reads it
+  auto tile = tileSize > 0 ? static_cast<size_t>(tileSize) : numSamples;
+
+  for (size_t start = 0; start < numSamples; start += tile)
+    processTile(block.getSubBlock(start, juce::jmin(tile, numSamples - start)), sidesIdentical);
+}
+
+void Project13_NewAudioProcessor::BandChain::processTile(juce::dsp::AudioBlock<float> block, bool sidesIdentical)
+{
+  //while the sides are the same, the stages run on the left alone, and the right gets a copy where the run ends
+  auto mono = sidesIdentical;
+
+  for (auto option : dspOrder)
+  {
+    if (mono && ! canRunMono(option))
+    {
+      block.getSingleChannelBlock(1).copyFrom(block.getSingleChannelBlock(0));
+      mono = false;
+    }
+
+    processStage(option, mono ? block.getSingleChannelBlock(0) : block, mono);
+  }
+
+  if (mono)
+    block.getSingleChannelBlock(1).copyFrom(block.getSingleChannelBlock(0));
+}
+
+bool Project13_NewAudioProcessor::BandChain::canRunMono(DSP_Option option)
+{
+  auto* stage = getStage(option);
+
+  //a stage that isn't running passes both sides through alike
+  if (stage == nullptr || ! stage->liveThisBlock)
+    return true;
+
+  switch (option)
+  {
+    case DSP_Option::Phase:
+    case DSP_Option::Chorus:
+    case DSP_Option::Overdrive:
+    case DSP_Option::LadderFilter:
+    case DSP_Option::GeneralFilter:
+      //a stale right side is by definition what the left holds, since it only went stale on identical input
+      return stage->rightStale || stage->channelsMatch(monoStateTolerance);
+    //ping-pong and stereo impulse responses make the sides differ, and their history is too long to copy every block
+    case DSP_Option::Delay:
+    case DSP_Option::Convolution:
+      return isBypassed(option);
+    case DSP_Option::END_OF_LIST: break;
+  }
+
+  return false;
+}
+
+void Project13_NewAudioProcessor::BandChain::processStage(DSP_Option option, juce::dsp::AudioBlock<float> block, bool leftOnly)
+{
+  auto* stage = getStage(option);
+
+  if (stage == nullptr)
+    return;
+
+  auto bypassed = isBypassed(option);
+
+  //not prepared yet: pass the audio through and ask for it, rather than prepare here
+  if (! stage->liveThisBlock)
+  {
+    if (! bypassed && stage->request())
+      stageRequested = true;
+
+    return;
+  }
+
+  if (leftOnly)
+  {
+    stage->rightStale = true;
+  }
+  else if (stage->rightStale)
+  {
+    stage->copyLeftToRight();
+    stage->rightStale = false;
+  }
+
+  PROJECT13_TRACE_SCOPE(getStageTraceName(option));
+  auto context = juce::dsp::ProcessContextReplacing<float>(block);
+  context.isBypassed = bypassed;
+  stage->processLive(context, juce::dsp::AudioBlock<float>(fadeScratch));
+}
+
+void Project13_NewAudioProcessor::BandChain::updateSvf()
+{
+  //the SVF glides to its targets itself, so it takes them every update
+  svfFilter.setControlInterval(svfControlInterval);
+  svfFilter.setParameters(static_cast<TptSvf::Mode>(juce::jlimit(0, 3, values.getIndex(ChainDiscrete::GeneralFilterMode))),
+                          values.get(ChainFloat::GeneralFilterFreq),
+                          values.get(ChainFloat::GeneralFilterQuality),
+                          values.get(ChainFloat::GeneralFilterGain));
+}
+
+void Project13_NewAudioProcessor::BandChain::updateDelay()
+{
+  TempoDelay::Settings settings;
+  settings.delayMs = values.get(ChainFloat::DelayTime);
+
+  if (values.isOn(ChainDiscrete::DelaySync) && tempoBpm > 0.0)
+  {
+    auto beats = TempoDelay::getNoteDivisionBeats(values.getIndex(ChainDiscrete::DelayNote));
+    settings.delayMs = static_cast<float>(60000.0 / tempoBpm) * beats;
+  }
+
+  settings.feedback = values.get(ChainFloat::DelayFeedback);
+  settings.mix = values.get(ChainFloat::DelayMix);
+  settings.lowCutHz = values.get(ChainFloat::DelayLowCut);
+  settings.highCutHz = values.get(ChainFloat::DelayHighCut);
+  settings.pingPong = values.isOn(ChainDiscrete::DelayPingPong);
+
+  delay.setSettings(settings);
+}
+
+size_t Project13_NewAudioProcessor::getNumActiveBands() const
+{
+  auto modeIndex = juce::roundToInt(packedDiscretes.back());
+  return static_cast<size_t>(juce::jlimit(1, static_cast<int>(maxBands), modeIndex + 1));
+}
+
 void Project13_NewAudioProcessor::releaseResources()
 {
     // When playback stops, you can use this as an opportunity to free up any
     // spare memory, etc.
 }
 
+void Project13_NewAudioProcessor::reset()
+{
+    for (auto& band : bands)
+        band.reset();
+
+    bandSplitter.reset();
+}
+
 #ifndef JucePlugin_PreferredChannelConfigurations
 bool Project13_NewAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
 {
@@ -305,9 +1159,8 @@ bool Project13_NewAudioProcessor::isBusesLayoutSupported (const BusesLayout& lay
 }
 #endif
 
-juce::AudioProcessorValueTreeState::ParameterLayout Project13_NewAudioProcessor::createParameterLayout() {
-
-    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+void addChainParameters(juce::AudioProcessorValueTreeState::ParameterLayout& layout, const juce::String& prefix)
+{
 
     //    name = namefunction
     //    layout.add(std::make_unique<juce::AudioParameters<float>>(
@@ -328,7 +1181,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13_NewAudioProcessor:
         Mix: 0 ot 1
     */
 
-    auto name = getPhaserRateName();
+    auto name = prefix + getPhaserRateName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID{ name,versionHint },
         name,
@@ -337,7 +1190,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13_NewAudioProcessor:
         "Hz"));
 
     //phaser depth 0 to -1
-    name = getPhaserDepthName();
+    name = prefix + getPhaserDepthName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID{ name,versionHint },
         name,
@@ -346,7 +1199,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13_NewAudioProcessor:
         "%"));
 
     //phaser center frequency
-    name = getPhaserCenterFreqName();
+    name = prefix + getPhaserCenterFreqName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID{ name,versionHint },
         name,
@@ -354,7 +1207,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13_NewAudioProcessor:
         1000.f,
         "Hz"));
     //phaser feedback
-    name = getPhaserFeedbackName();
+    name = prefix + getPhaserFeedbackName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID{ name,versionHint },
         name,
@@ -362,14 +1215,14 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13_NewAudioProcessor:
         0.0f,
         "%"));
     //phaser mix
-    name = getPhaserMixName();
+    name = prefix + getPhaserMixName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID{ name,versionHint },
         name,
         juce::NormalisableRange<float>(0.01f, 1.f, 0.01f, 1.f),
         0.05f,
         "%"));
-    name = getPhaserBypassName();
+    name = prefix + getPhaserBypassName();
     layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{name,versionHint},
     name,false));
 
@@ -381,7 +1234,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13_NewAudioProcessor:
     Feedback: -1 to 1
     Mix: 0 ot 1
 */
-    name = getChorusRateName();
+    name = prefix + getChorusRateName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID{ name,versionHint },
         name,
@@ -389,7 +1242,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13_NewAudioProcessor:
         0.2f,
         "Hz"));
     //chorus depth
-    name = getChorusDepthName();
+    name = prefix + getChorusDepthName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID{ name,versionHint },
         name,
@@ -397,7 +1250,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13_NewAudioProcessor:
         0.05f,
         "%"));
     //chorus center delay
-    name = getChorusCenterDelayName();
+    name = prefix + getChorusCenterDelayName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID{ name,versionHint },
         name,
@@ -405,7 +1258,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13_NewAudioProcessor:
         7.f,
         "%"));
     //chorus feedback
-    name = getChorusFeedbackName();
+    name = prefix + getChorusFeedbackName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID{ name,versionHint },
         name,
@@ -413,14 +1266,14 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13_NewAudioProcessor:
         0.0f,
         "%"));
     //chorus  mix
-    name = getChorusMixName();
+    name = prefix + getChorusMixName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID{ name,versionHint },
         name,
         juce::NormalisableRange<float>(0.01f, 1.f, 0.01f, 1.f),
         0.05f,
         "%"));
-    name = getChorusBypassName();
+    name = prefix + getChorusBypassName();
     layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{name,versionHint},name,false));
     /*
         overdrive
@@ -428,7 +1281,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13_NewAudioProcessor:
         drive 1-100
     */
     //drive 1-100
-    name = getOverdriveSaturationName();
+    name = prefix + getOverdriveSaturationName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID{ name,versionHint },
         name,
@@ -436,7 +1289,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13_NewAudioProcessor:
         1.f,
         ""));
 
-  name = getOverdriveBypassName();
+  name = prefix + getOverdriveBypassName();
   layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{name,versionHint},name,false));
     /*Ladder
         mode: ladder filter enum(int)
@@ -445,7 +1298,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13_NewAudioProcessor:
         drive 1-100
     */
 
-    name = getLadderFilterModeName();
+    name = prefix + getLadderFilterModeName();
     auto choices = getLadderFilterChoices();
     layout.add(std::make_unique<juce::AudioParameterChoice>
     (
@@ -455,28 +1308,28 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13_NewAudioProcessor:
         0
     ));
 
-    name = getLadderFilterCutoffName();
+    name = prefix + getLadderFilterCutoffName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID{ name,versionHint },
         name,
         juce::NormalisableRange<float>(20.f, 20000.f, 0.1f, 1.f),
         20000.f,
         "Hz"));
-    name = getLadderFilterResonanceName();
+    name = prefix + getLadderFilterResonanceName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID{ name,versionHint },
         name,
         juce::NormalisableRange<float>(0.f, 1.f, 0.01f, 1.f),
         0.f,
         ""));
-    name = getLadderFilterDriveName();
+    name = prefix + getLadderFilterDriveName();
     layout.add(std::make_unique<juce::AudioParameterFloat>(
         juce::ParameterID{ name,versionHint },
         name,
         juce::NormalisableRange<float>(1.f, 100.f, 0.1f, 1.f),
         1.f,
         ""));
-    name = getLadderFilterBypassName();
+    name = prefix + getLadderFilterBypassName();
     layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{name,versionHint},name,false));
 
     /*General Filter
@@ -487,7 +1340,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13_NewAudioProcessor:
         gain: -24db to 24 db in 0.5 db increments
      */
     //mode
-    name = getGeneralFilterModeName();
+    name = prefix + getGeneralFilterModeName();
     choices = getGeneralFilterChoices();
     layout.add(std::make_unique<juce::AudioParameterChoice>
         (
@@ -497,7 +1350,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13_NewAudioProcessor:
             0
         ));
     //freq
-    name = getGeneralFilterFreqName();
+    name = prefix + getGeneralFilterFreqName();
     layout.add(std::make_unique<juce::AudioParameterFloat>
         (
             juce::ParameterID{ name,versionHint },
@@ -507,7 +1360,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13_NewAudioProcessor:
             "Hz"
         ));
     //quality
-    name = getGeneralFilterQuatlityName();
+    name = prefix + getGeneralFilterQuatlityName();
     layout.add(std::make_unique<juce::AudioParameterFloat>
         (
             juce::ParameterID{ name,versionHint },
@@ -517,7 +1370,7 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13_NewAudioProcessor:
             ""
         ));
     //gain
-    name = getGeneralFilterGainName();
+    name = prefix + getGeneralFilterGainName();
     layout.add(std::make_unique < juce::AudioParameterFloat >
         (
             juce::ParameterID{ name,versionHint },
@@ -526,41 +1379,275 @@ juce::AudioProcessorValueTreeState::ParameterLayout Project13_NewAudioProcessor:
             0.f,
             "dB"
         ));
-    name = getGeneralFilterBypassName();
+    name = prefix + getGeneralFilterBypassName();
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{name,versionHint},name,false));
+    //topology: biquad, or an SVF that glides its settings per sample
+    name = prefix + getGeneralFilterTopologyName();
+    layout.add(std::make_unique<juce::AudioParameterChoice>
+        (
+            juce::ParameterID{ name,versionHint },
+            name,
+            getGeneralFilterTopologyChoices(),
+            0
+        ));
+
+    /*Delay
+        time: 1 - 2000 ms, used when sync is off
+        sync: follow the host tempo with note: 1/1 to 1/32, dotted and triplets
+        feedback: 0 - 0.95
+        mix: 0 to 1
+        low / high cut: filters inside the feedback loop
+        ping pong: echoes alternate between left and right
+        bypassed by default so sessions saved before the delay existed sound the same
+     */
+    name = prefix + getDelayTimeName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name,versionHint },
+        name,
+        juce::NormalisableRange<float>(TempoDelay::minDelayMs, TempoDelay::maxDelayMs, 0.1f, 0.5f),
+        375.f,
+        "ms"));
+    name = prefix + getDelaySyncName();
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{name,versionHint},name,false));
+    name = prefix + getDelayNoteName();
+    layout.add(std::make_unique<juce::AudioParameterChoice>
+        (
+            juce::ParameterID{ name,versionHint },
+            name,
+            TempoDelay::getNoteDivisionNames(),
+            8
+        ));
+    name = prefix + getDelayFeedbackName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name,versionHint },
+        name,
+        juce::NormalisableRange<float>(0.f, 0.95f, 0.01f, 1.f),
+        0.35f,
+        "%"));
+    name = prefix + getDelayMixName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name,versionHint },
+        name,
+        juce::NormalisableRange<float>(0.f, 1.f, 0.01f, 1.f),
+        0.3f,
+        "%"));
+    name = prefix + getDelayLowCutName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name,versionHint },
+        name,
+        juce::NormalisableRange<float>(20.f, 2000.f, 1.f, 0.3f),
+        80.f,
+        "Hz"));
+    name = prefix + getDelayHighCutName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name,versionHint },
+        name,
+        juce::NormalisableRange<float>(1000.f, 20000.f, 1.f, 0.3f),
+        8000.f,
+        "Hz"));
+    name = prefix + getDelayPingPongName();
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{name,versionHint},name,false));
+    name = prefix + getDelayBypassName();
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{name,versionHint},name,true));
+
+    /*Convolution
+        mix: 0 to 1
+        the impulse response is loaded from a file and saved with the state, not a parameter
+        bypassed by default, like the delay
+     */
+    name = prefix + getConvolutionMixName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>(
+        juce::ParameterID{ name,versionHint },
+        name,
+        juce::NormalisableRange<float>(0.f, 1.f, 0.01f, 1.f),
+        1.f,
+        "%"));
+    name = prefix + getConvolutionBypassName();
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{name,versionHint},name,true));
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout Project13_NewAudioProcessor::createParameterLayout() {
+
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+
+    const int versionHint = 1;
+
+    for (size_t band = 0; band < Project13_NewAudioProcessor::maxBands; ++band)
+        addChainParameters(layout, getBandPrefix(band));
+
+    /*
+        Multiband:
+        mode: off, 2, 3 or 4 bands
+        crossovers: 20hz - 20000hz, kept ascending when they are applied
+    */
+    auto name = getMultibandModeName();
+    layout.add(std::make_unique<juce::AudioParameterChoice>
+        (
+            juce::ParameterID{ name,versionHint },
+            name,
+            getMultibandChoices(),
+            0
+        ));
+
+    auto crossoverNames = std::array { getCrossover1Name(), getCrossover2Name(), getCrossover3Name() };
+    auto crossoverDefaults = std::array { 200.f, 1000.f, 5000.f };
+
+    for (size_t i = 0; i < crossoverNames.size(); ++i)
+    {
+        name = crossoverNames[i];
+        layout.add(std::make_unique<juce::AudioParameterFloat>
+            (
+                juce::ParameterID{ name,versionHint },
+                name,
+                juce::NormalisableRange<float>(20.f, 20000.f, 1.f, 1.f),
+                crossoverDefaults[i],
+                "Hz"
+            ));
+    }
+
+    /*
+        Morph:
+        position: 0 to 1 through the captured snapshots
+        enabled: chains follow the snapshots instead of the live values
+    */
+    name = getMorphPositionName();
+    layout.add(std::make_unique<juce::AudioParameterFloat>
+        (
+            juce::ParameterID{ name,versionHint },
+            name,
+            juce::NormalisableRange<float>(0.f, 1.f, 0.001f, 1.f),
+            0.f,
+            ""
+        ));
+    name = getMorphEnabledName();
     layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{name,versionHint},name,false));
+
+    //off by default: quality only drops when the user has said it may
+    name = getAdaptiveQualityName();
+    layout.add(std::make_unique<juce::AudioParameterBool>(juce::ParameterID{name,versionHint},name,false));
+
+    /*
+        Mono fast path:
+        off: both sides always run the whole chain
+        auto: while the input's sides are bit-identical, the chain runs on the
+        left alone up to the first stage that would make them differ
+    */
+    name = getMonoPathName();
+    layout.add(std::make_unique<juce::AudioParameterChoice>
+        (
+            juce::ParameterID{ name,versionHint },
+            name,
+            getMonoPathChoices(),
+            1
+        ));
+
     return layout;
 
 }
 
-void Project13_NewAudioProcessor::MonoChannelDSP::updateDSPFromParams(){
-  
-  phaser.dsp.setRate(p.phaserRateHz->get());
-  phaser.dsp.setCentreFrequency(p.phaserCenterFreqHz->get());
-  phaser.dsp.setDepth(p.phaserDepthPercent->get());
-  phaser.dsp.setFeedback(p.phaserFeedbackPercent->get());
-  phaser.dsp.setMix(p.phaserMixPercent->get());
-
-  chorus.dsp.setRate(p.chorusRateHz->get());
-  chorus.dsp.setDepth(p.chorusDepthPercent->get());
-  chorus.dsp.setCentreDelay(p.chorusCenterDelayMs->get());
-  chorus.dsp.setFeedback(p.chorusFeedbackPercent->get());
-  chorus.dsp.setMix(p.chorusMixPercent->get());
-  overdrive.dsp.setDrive(p.overdriveSaturation->get());
-
-  ladderFilter.dsp.setMode(
-    static_cast<juce::dsp::LadderFilterMode>(p.ladderFilterMode->getIndex())
-  );
-  ladderFilter.dsp.setCutoffFrequencyHz(p.ladderFilterCutoffHz->get());
-  ladderFilter.dsp.setResonance(p.ladderFilterResonance->get());
-  ladderFilter.dsp.setDrive(p.ladderFilterDrive->get());
+void Project13_NewAudioProcessor::BandChain::updateDSPFromParams(){
+  PROJECT13_TRACE_SCOPE("updateDSPFromParams");
+  const auto& v = values;
 
-  
- //TODO: update general fileter coefficients here
-  
+  //stages still waiting for preparation may be in use by the preparation thread
+  if (phaser.liveThisBlock)
+  {
+    phaser.setRate(v.get(ChainFloat::PhaserRate));
+    phaser.setCentreFrequency(v.get(ChainFloat::PhaserCenterFreq));
+    phaser.setDepth(v.get(ChainFloat::PhaserDepth));
+    phaser.setFeedback(v.get(ChainFloat::PhaserFeedback));
+    phaser.setMix(v.get(ChainFloat::PhaserMix));
+  }
+
+  if (chorus.liveThisBlock)
+  {
+    chorus.setControlInterval(chorusControlInterval);
+    chorus.setRate(v.get(ChainFloat::ChorusRate));
+    chorus.setDepth(v.get(ChainFloat::ChorusDepth));
+    chorus.setCentreDelay(v.get(ChainFloat::ChorusCenterDelay));
+    chorus.setFeedback(v.get(ChainFloat::ChorusFeedback));
+    chorus.setMix(v.get(ChainFloat::ChorusMix));
+  }
+
+  if (overdrive.liveThisBlock)
+    overdrive.setDrive(v.get(ChainFloat::OverdriveSaturation));
+
+  if (ladderFilter.liveThisBlock)
+  {
+    ladderFilter.setMode(
+      static_cast<StereoLadder::Mode>(v.getIndex(ChainDiscrete::LadderFilterMode))
+    );
+    ladderFilter.setCutoffFrequencyHz(v.get(ChainFloat::LadderFilterCutoff));
+    ladderFilter.setResonance(v.get(ChainFloat::LadderFilterResonance));
+    ladderFilter.setDrive(v.get(ChainFloat::LadderFilterDrive));
+  }
+
+  if (generalFilter.liveThisBlock && ! usesSvf())
+    updateGeneralFilter();
+
+  if (svfFilter.liveThisBlock && usesSvf())
+    updateSvf();
+
+  if (delay.liveThisBlock)
+    updateDelay();
+
+  if (convolution.liveThisBlock)
+    convolution.setMix(v.get(ChainFloat::ConvolutionMix));
  }
+
+void Project13_NewAudioProcessor::BandChain::updateGeneralFilter()
+{
+  auto mode = juce::jlimit(0, 3, values.getIndex(ChainDiscrete::GeneralFilterMode));
+  auto settings = std::array
+  {
+    static_cast<float>(mode),
+    values.get(ChainFloat::GeneralFilterFreq),
+    values.get(ChainFloat::GeneralFilterQuality),
+    values.get(ChainFloat::GeneralFilterGain),
+  };
+
+  if (sampleRate <= 0.0 || settings == lastFilterSettings)
+    return;
+
+  lastFilterSettings = settings;
+
+  //the exact RBJ formulas; they only run when a setting has changed
+  using ArrayCoefficients = juce::dsp::IIR::ArrayCoefficients<float>;
+  auto freq = juce::jmin(settings[1], static_cast<float>(sampleRate * 0.49));
+  auto q = settings[2];
+  std::array<float, 6> biquad {};
+
+  switch (static_cast<TptSvf::Mode>(mode))
+  {
+    case TptSvf::Mode::Peak:
+      biquad = ArrayCoefficients::makePeakFilter(sampleRate, freq, q, juce::Decibels::decibelsToGain(settings[3]));
+      break;
+    case TptSvf::Mode::BandPass:
+      biquad = ArrayCoefficients::makeBandPass(sampleRate, freq, q);
+      break;
+    case TptSvf::Mode::Notch:
+      biquad = ArrayCoefficients::makeNotch(sampleRate, freq, q);
+      break;
+    case TptSvf::Mode::AllPass:
+      biquad = ArrayCoefficients::makeAllPass(sampleRate, freq, q);
+      break;
+  }
+
+  generalFilter.setCoefficients(biquad);
+}
 void Project13_NewAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
     juce::ScopedNoDenormals noDenormals;
+    PROJECT13_TRACE_SCOPE("processBlock");
+
+    //timed up to the last return, whichever path the block takes
+    auto blockStartTicks = juce::Time::getHighResolutionTicks();
+    const juce::ScopeGuard reportBlockTime { [this, blockStartTicks, numSamples = buffer.getNumSamples()]
+    {
+        auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - blockStartTicks);
+        qualityGovernor.blockFinished(elapsed, numSamples);
+    } };
+
     auto totalNumInputChannels  = getTotalNumInputChannels();
     auto totalNumOutputChannels = getTotalNumOutputChannels();
 
@@ -577,84 +1664,253 @@ void Project13_NewAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer
     //[DONE]: create audio parameteres for all audio parameter
     //[DONE]: update DSP here from audio parameters
   //[DONE]:bypassparams for each dsp element 
-    //TODO: update genral filter corrections
+    //[DONE]: update genral filter corrections
     //[TODO]: add smother for all param update
     //[DONE]: save/load settings
     //[DONE]: save/load DSP order
   //[DONE]: bypass dsp
     //[DONE]: filters are mono not stereo
-    //[TODO]: drag to reorder gui
-    //[TODO]: GUI design for each dsp instance
+    //[DONE]: drag to reorder gui
+    //[DONE]: GUI design for each dsp instance
     //[TODO]: metering
     //[DONE]: preparing all dsp
-    leftChannel.updateDSPFromParams();
-    rightChannel.updateDSPFromParams();
-    auto newDSPOrder = DSP_Order();
+    for (size_t b = 0; b < maxBands; ++b)
+    {
+        auto newDSPOrder = DSP_Order();
+
+        //try to pull
+        while (dspOrderFifos[b].pull(newDSPOrder))
+        {
+
+        }
+
+        //if you pull replace dsp order
+        if (newDSPOrder != DSP_Order())
+        {
+            PROJECT13_TRACE_INSTANT("DSP order handoff");
+            bands[b].dspOrder = newDSPOrder;
+        }
+    }
+
+    morphSnapshotQueue.pull([this](std::unique_ptr<Morpher::SnapshotSet>& incoming)
+    {
+        PROJECT13_TRACE_INSTANT("Morph snapshot handoff");
+        morpher.setSnapshots(incoming);
+    });
 
-    //try to pull
-    while (dspOrderFifo.pull(newDSPOrder))
+  if (auto* playHead = getPlayHead())
+  {
+    if (auto position = playHead->getPosition())
     {
+      if (auto bpm = position->getBpm())
+        hostBpm = *bpm;
+    }
+  }
+
+  //a bounce has no deadline, and its output should not depend on how busy the machine was
+  qualityGovernor.setEnabled(adaptiveQuality->get() && ! isNonRealtime());
+  auto quality = qualityGovernor.getLevel();
+
+  for (auto& band : bands)
+  {
+    band.tempoBpm = hostBpm;
+    band.tileSize = tileSize.load(std::memory_order_relaxed);
+    band.svfControlInterval = getSvfControlInterval(quality);
+    band.chorusControlInterval = getChorusControlInterval(quality);
+    band.monoPathEnabled = monoPath->getIndex() != 0;
+    band.convolution.setWaitForTail(isNonRealtime());
+  }
+
+  auto block = juce::dsp::AudioBlock<float>(buffer).getSubsetChannelBlock(0, static_cast<size_t>(juce::jmin(totalNumInputChannels, 2)));
+  auto numSamples = static_cast<int>(block.getNumSamples());
+
+  smoothedMorphPosition.setTargetValue(morphPosition->get());
+
+  if (! morphEnabled->get() || ! morpher.canMorph())
+  {
+    currentMorphStep = 0;
+    smoothedMorphPosition.skip(numSamples);
+    readParamValues(packedFloats.data(), packedDiscretes.data());
+  }
+  else
+  {
+    //the chains re-pack every sub-block so a sweep is smooth; the band count is taken from where it starts
+    currentMorphStep = getMorphSubBlockSize(quality);
+    morpher.morph(smoothedMorphPosition.getCurrentValue(), packedFloats.data(), packedDiscretes.data());
+  }
+
+  processChains(block);
+  requestPreparationIfNeeded();
+}
+
+void Project13_NewAudioProcessor::processChains(juce::dsp::AudioBlock<float> block)
+{
+    //offline there is no deadline, so a bounce never contains stages that were still waiting; the lock is only taken when one is
+    if (isNonRealtime() && hasUnpreparedActiveStages())
+        prepareActiveStages();
+
+    auto numBands = getNumActiveBands();
 
+    if (numBands > 1)
+        processMultiband(block, numBands);
+    else
+        processFullBand(block);
+}
+
+void Project13_NewAudioProcessor::processFullBand(juce::dsp::AudioBlock<float> block)
+{
+    if (currentMorphStep == 0)
+    {
+        bands[0].process(block);
+        return;
     }
 
-    //if you pull replace dsp order
-    if (newDSPOrder != DSP_Order())
-        dspOrder = newDSPOrder;
+    auto numSamples = static_cast<int>(block.getNumSamples());
 
-  auto block = juce::dsp::AudioBlock<float>(buffer);
-  leftChannel.process(block.getSingleChannelBlock(0), dspOrder);
-  rightChannel.process(block.getSingleChannelBlock(1),dspOrder);
-    //now convert dspOrder into an array of pointers
+    for (int start = 0; start < numSamples; start += currentMorphStep)
+    {
+        auto subBlockSize = juce::jmin(currentMorphStep, numSamples - start);
+        morpher.morph(smoothedMorphPosition.skip(subBlockSize), packedFloats.data(), packedDiscretes.data());
+        bands[0].process(block.getSubBlock(static_cast<size_t>(start), static_cast<size_t>(subBlockSize)));
+    }
 }
 
-void Project13_NewAudioProcessor::MonoChannelDSP::process(juce::dsp::AudioBlock<float> block, const DSP_Order &dspOrder){
-  
-    DSP_Pointers dspPointers;
-    dspPointers.fill({});//dspPointers.fill(nullptr); 
+void Project13_NewAudioProcessor::processBand(size_t band, juce::dsp::AudioBlock<float> block)
+{
+    if (currentMorphStep == 0)
+    {
+        bands[band].process(block);
+        return;
+    }
+
+    auto numSamples = static_cast<int>(block.getNumSamples());
+    size_t subBlock = 0;
+
+    for (int start = 0; start < numSamples; start += currentMorphStep)
+    {
+        //the slices don't overlap, so the workers can re-pack side by side
+        morpher.morphSlice(morphPositions[subBlock++], packedFloats.data(), packedDiscretes.data(),
+                           band * numChainFloats, numChainFloats,
+                           band * numChainDiscretes, numChainDiscretes);
+
+        auto subBlockSize = juce::jmin(currentMorphStep, numSamples - start);
+        bands[band].process(block.getSubBlock(static_cast<size_t>(start), static_cast<size_t>(subBlockSize)));
+    }
+}
 
-    for (size_t i = 0; i < dspPointers.size(); ++i)
+void Project13_NewAudioProcessor::processMultiband(juce::dsp::AudioBlock<float> io, size_t numBands)
+{
+    //keep the crossovers ascending and below nyquist whatever the automation does
+    auto updateCrossovers = [this]
     {
-        switch (dspOrder[i])
+        std::array<float, maxBands - 1> crossovers;
+        auto lowest = 20.f;
+        auto highest = static_cast<float>(getSampleRate() * 0.45);
+
+        for (size_t i = 0; i < crossovers.size(); ++i)
         {
-         case DSP_Option::Phase: dspPointers[i].processor = &phaser;
-                dspPointers[i].bypassed = p.phaserBypass->get();
-                break;
-         case DSP_Option::Chorus: 
-                dspPointers[i].processor = &chorus;
-                dspPointers[i].bypassed = p.chorusBypass->get();
-                break;
-         case DSP_Option::Overdrive:
-                dspPointers[i].processor = &overdrive;
-                dspPointers[i].bypassed = p.overdriveBypass->get();
-                break;
-         case DSP_Option::LadderFilter:
-                dspPointers[i].processor = &ladderFilter;
-                dspPointers[i].bypassed = p.ladderFilterBypass->get();
-                break;
-        case DSP_Option::GeneralFilter:
-                dspPointers[i].processor = &generalFilter; 
-                dspPointers[i].bypassed = p.generalFilterBypass->get();
-                break;
-         case DSP_Option::END_OF_LIST:
-                jassertfalse;
-                break;
+            crossovers[i] = juce::jlimit(lowest, highest, getPackedCrossover(i));
+            lowest = juce::jmin(crossovers[i] + 1.f, highest);
         }
-    }
-    //now processs:
-    auto context = juce::dsp::ProcessContextReplacing<float>(block);
 
-    for (size_t i = 0; i < dspPointers.size();++i)
+        bandSplitter.setCrossovers(crossovers);
+    };
+
+    updateCrossovers();
+
+    auto numChannels = io.getNumChannels();
+    auto numSamples = static_cast<int>(io.getNumSamples());
+
+    //offline bounces and big realtime blocks are where spreading the bands across cores pays off
+    auto useWorkers = isNonRealtime() || numSamples >= parallelBandsMinSamples;
+
+    //until every band has its buffer, run the full-band chain rather than wait for an allocation
+    auto buffersReady = true;
+
+    for (size_t b = 0; b < numBands; ++b)
     {
-        if (dspPointers[i].processor != nullptr)
+        if (! bands[b].bufferReady.load(std::memory_order_acquire))
         {
-            juce::ScopedValueSetter<bool> svs(context.isBypassed,dspPointers[i].bypassed);
-            dspPointers[i].processor->process(context);
+            if (! bands[b].bufferWanted.exchange(true, std::memory_order_relaxed))
+                bufferRequested = true;
+
+            buffersReady = false;
         }
     }
-    
 
+    if (! buffersReady)
+    {
+        PROJECT13_TRACE_INSTANT("Band buffers not ready");
+        processFullBand(io);
+        return;
+    }
+
+    std::array<juce::dsp::AudioBlock<float>, maxBands> bandBlocks;
+    BandWorkerPool::Job job { [this, &bandBlocks](size_t b) { processBand(b, bandBlocks[b]); } };
+
+    //some hosts send more than they promised in prepareToPlay, so walk the buffer in prepared-size chunks
+    jassert(preparedBlockSize > 0);
+    auto maxChunk = juce::jmax(1, preparedBlockSize);
+
+    for (int start = 0; start < numSamples; start += maxChunk)
+    {
+        auto chunkSize = juce::jmin(maxChunk, numSamples - start);
+        auto input = io.getSubBlock(static_cast<size_t>(start), static_cast<size_t>(chunkSize));
+
+        for (size_t b = 0; b < numBands; ++b)
+        {
+            bandBlocks[b] = juce::dsp::AudioBlock<float>(bands[b].buffer)
+                                .getSubsetChannelBlock(0, numChannels)
+                                .getSubBlock(0, static_cast<size_t>(chunkSize));
+        }
+
+        if (currentMorphStep == 0)
+        {
+            PROJECT13_TRACE_SCOPE("Band split");
+            bandSplitter.split(input, bandBlocks, numBands);
+        }
+        else
+        {
+            //the crossovers follow the sweep here; the bands then take the whole chunk in one dispatch
+            PROJECT13_TRACE_SCOPE("Band split");
+            size_t subBlock = 0;
+
+            for (int subStart = 0; subStart < chunkSize; subStart += currentMorphStep)
+            {
+                auto subBlockSize = static_cast<size_t>(juce::jmin(currentMorphStep, chunkSize - subStart));
+                auto position = smoothedMorphPosition.skip(static_cast<int>(subBlockSize));
+
+                jassert(subBlock < morphPositions.size());
+                morphPositions[subBlock++] = position;
+                morpher.morph(position, packedFloats.data(), packedDiscretes.data());
+                updateCrossovers();
+
+                std::array<juce::dsp::AudioBlock<float>, maxBands> subBlocks;
+
+                for (size_t b = 0; b < numBands; ++b)
+                    subBlocks[b] = bandBlocks[b].getSubBlock(static_cast<size_t>(subStart), subBlockSize);
+
+                bandSplitter.split(input.getSubBlock(static_cast<size_t>(subStart), subBlockSize), subBlocks, numBands);
+            }
+        }
+
+        if (useWorkers)
+        {
+            bandWorkers->run(numBands, job);
+        }
+        else
+        {
+            for (size_t b = 0; b < numBands; ++b)
+                job(b);
+        }
+
+        input.copyFrom(bandBlocks[0]);
+
+        for (size_t b = 1; b < numBands; ++b)
+            input.add(bandBlocks[b]);
+    }
 }
-  
+
 //==============================================================================
 bool Project13_NewAudioProcessor::hasEditor() const
 {
@@ -663,8 +1919,48 @@ bool Project13_NewAudioProcessor::hasEditor() const
 
 juce::AudioProcessorEditor* Project13_NewAudioProcessor::createEditor()
 {
-   // return new Project13_NewAudioProcessorEditor (*this);
-    return new juce::GenericAudioProcessorEditor(*this);
+    return new Project13_NewAudioProcessorEditor (*this);
+}
+
+void Project13_NewAudioProcessor::requestDSPOrder(size_t band, const DSP_Order& newOrder)
+{
+    jassert(band < maxBands);
+    requestedDSPOrders[band] = newOrder;
+    dspOrderFifos[band].push(newOrder);
+    dspOrderBroadcaster.sendChangeMessage();
+}
+
+void Project13_NewAudioProcessor::publishMorphSnapshots()
+{
+    auto snapshots = std::make_unique<Morpher::SnapshotSet>(requestedMorphSnapshots);
+
+    //only full when nothing has been pulled for a while, e.g. on a suspended track. Each retry copies
+    //requestedMorphSnapshots afresh, so changes made in the meantime coalesce into the set that goes through
+    if (morphSnapshotQueue.push(snapshots))
+        morphSnapshotRetry.stopTimer();
+    else
+        morphSnapshotRetry.startTimer(morphSnapshotRetryMs);
+}
+
+void Project13_NewAudioProcessor::captureMorphSnapshot(size_t slot)
+{
+    jassert(slot < Morpher::maxSnapshots);
+    auto& snapshot = requestedMorphSnapshots.snapshots[slot];
+
+    readParamValues(snapshot.floats.data(), snapshot.discretes.data());
+    requestedMorphSnapshots.captured[slot] = true;
+
+    publishMorphSnapshots();
+    morphSnapshotBroadcaster.sendChangeMessage();
+}
+
+void Project13_NewAudioProcessor::clearMorphSnapshot(size_t slot)
+{
+    jassert(slot < Morpher::maxSnapshots);
+    requestedMorphSnapshots.captured[slot] = false;
+
+    publishMorphSnapshots();
+    morphSnapshotBroadcaster.sendChangeMessage();
 }
 
 template<>
@@ -684,22 +1980,30 @@ struct juce::VariantConverter<Project13_NewAudioProcessor::DSP_Order> {
     }
     else
     {
+      using DSP_Option = Project13_NewAudioProcessor::DSP_Option;
+
       auto mb = *v.getBinaryData();
       juce::MemoryInputStream mis(mb,false);
-      std::vector<int> arr;
-      while( !mis.isExhausted())
+      std::vector<DSP_Option> arr;
+      while( !mis.isExhausted() && arr.size() < dspOrder.size())
       {
-        arr.push_back(mis.readInt());
+        auto option = mis.readInt();
 
+        if (option >= 0 && option < static_cast<int>(DSP_Option::END_OF_LIST)
+            && std::find(arr.begin(), arr.end(), static_cast<DSP_Option>(option)) == arr.end())
+          arr.push_back(static_cast<DSP_Option>(option));
       }
 
-      jassert(arr.size()==dspOrder.size());
-
-      for(size_t i=0; i<dspOrder.size();++i)
+      //orders saved before a stage existed are shorter; the new stages go on the end
+      for (int i = 0; i < static_cast<int>(DSP_Option::END_OF_LIST); ++i)
       {
-        dspOrder[i]= static_cast<Project13_NewAudioProcessor::DSP_Option>(arr[i]);
+        if (std::find(arr.begin(), arr.end(), static_cast<DSP_Option>(i)) == arr.end())
+          arr.push_back(static_cast<DSP_Option>(i));
       }
 
+      jassert(arr.size()==dspOrder.size());
+      std::copy(arr.begin(), arr.end(), dspOrder.begin());
+
     }
 
     return dspOrder;
@@ -728,7 +2032,34 @@ void Project13_NewAudioProcessor::getStateInformation (juce::MemoryBlock& destDa
     // You should use this method to store your parameters in the memory block.
     // You could do that either as raw data, or use the XML or ValueTree classes
     // as intermediaries to make it easy to save and load complex data.
-  apvts.state.setProperty("dspOrder",juce::VariantConverter<Project13_NewAudioProcessor::DSP_Order>::toVar(dspOrder),nullptr);
+  for (size_t band = 0; band < maxBands; ++band)
+    apvts.state.setProperty(getDSPOrderPropertyName(band),juce::VariantConverter<Project13_NewAudioProcessor::DSP_Order>::toVar(requestedDSPOrders[band]),nullptr);
+  apvts.state.setProperty(getImpulseResponsePropertyName(), getImpulseResponseFile().getFullPathName(), nullptr);
+  for (size_t slot = 0; slot < Morpher::maxSnapshots; ++slot)
+  {
+    auto propertyName = getMorphSnapshotPropertyName(slot);
+
+    if (! requestedMorphSnapshots.captured[slot])
+    {
+      apvts.state.removeProperty(propertyName, nullptr);
+      continue;
+    }
+
+    const auto& snapshot = requestedMorphSnapshots.snapshots[slot];
+    juce::MemoryBlock mb;
+    {
+      juce::MemoryOutputStream snapshotStream(mb,false);
+      snapshotStream.writeInt(static_cast<int>(numPackedFloats));
+      snapshotStream.writeInt(static_cast<int>(numPackedDiscretes));
+
+      for (auto f : snapshot.floats)
+        snapshotStream.writeFloat(f);
+      for (auto d : snapshot.discretes)
+        snapshotStream.writeFloat(d);
+    }
+    apvts.state.setProperty(propertyName, mb, nullptr);
+  }
+
   juce::MemoryOutputStream mos(destData,false);
   apvts.state.writeToStream(mos);
 
@@ -744,11 +2075,51 @@ void Project13_NewAudioProcessor::setStateInformation (const void* data, int siz
   {
     apvts.replaceState(tree);
 
-    if(apvts.state.hasProperty("dspOrder"))
+    for (size_t band = 0; band < maxBands; ++band)
     {
-      auto order = juce::VariantConverter<Project13_NewAudioProcessor::DSP_Order>::fromVar(apvts.state.getProperty("dspOrder"));
-      dspOrderFifo.push(order);
+      auto propertyName = getDSPOrderPropertyName(band);
+
+      if(apvts.state.hasProperty(propertyName))
+      {
+        auto order = juce::VariantConverter<Project13_NewAudioProcessor::DSP_Order>::fromVar(apvts.state.getProperty(propertyName));
+        requestDSPOrder(band, order);
+      }
+    }
+
+    auto irPath = apvts.state.getProperty(getImpulseResponsePropertyName()).toString();
+
+    if (irPath != getImpulseResponseFile().getFullPathName())
+      loadImpulseResponse(juce::File::isAbsolutePath(irPath) ? juce::File(irPath) : juce::File());
+
+    for (size_t slot = 0; slot < Morpher::maxSnapshots; ++slot)
+    {
+      auto& snapshot = requestedMorphSnapshots.snapshots[slot];
+      auto& captured = requestedMorphSnapshots.captured[slot];
+      auto property = apvts.state.getProperty(getMorphSnapshotPropertyName(slot));
+      captured = false;
+
+      auto* mb = property.getBinaryData();
+      auto expectedSize = 2 * sizeof(int) + (numPackedFloats + numPackedDiscretes) * sizeof(float);
+
+      if (mb == nullptr || mb->getSize() != expectedSize)
+        continue;
+
+      juce::MemoryInputStream mis(*mb,false);
+
+      //only accept snapshots saved with the same parameter layout
+      if (mis.readInt() == static_cast<int>(numPackedFloats) && mis.readInt() == static_cast<int>(numPackedDiscretes))
+      {
+        for (auto& f : snapshot.floats)
+          f = mis.readFloat();
+        for (auto& d : snapshot.discretes)
+          d = mis.readFloat();
+
+        captured = true;
+      }
     }
+
+    publishMorphSnapshots();
+    morphSnapshotBroadcaster.sendChangeMessage();
     DBG(apvts.state.toXmlString()); 
   }
 }
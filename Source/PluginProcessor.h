@@ -11,6 +11,20 @@
 #include "juce_dsp/juce_dsp.h"
 #include <JuceHeader.h>
 #include<../SimpleMultiBandComp/Source/DSP/Fifo.h>
+#include "DSP/BandSplitter.h"
+#include "DSP/BandWorkerPool.h"
+#include "DSP/PresetMorpher.h"
+#include "DSP/LazyPreparation.h"
+#include "DSP/TempoDelay.h"
+#include "DSP/TptSvf.h"
+#include "DSP/StereoPhaser.h"
+#include "DSP/StereoChorus.h"
+#include "DSP/StereoLadder.h"
+#include "DSP/StereoBiquad.h"
+#include "DSP/PartitionedConvolution.h"
+#include "DSP/QualityGovernor.h"
+#include "DSP/CommandQueue.h"
+#include "Diagnostics/TimelineTrace.h"
 //==============================================================================
 /**
 */
@@ -27,6 +41,8 @@ public:
     //==============================================================================
     void prepareToPlay (double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
+    /** clears every live stage, so a transport jump doesn't ring on with what came before it */
+    void reset() override;
 
    #ifndef JucePlugin_PreferredChannelConfigurations
     bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
@@ -63,6 +79,8 @@ public:
         Overdrive,
         LadderFilter,
         GeneralFilter,
+        Delay,
+        Convolution,
         END_OF_LIST
     };
 
@@ -70,98 +88,395 @@ public:
     juce::AudioProcessorValueTreeState apvts{ *this, nullptr, "Settings", createParameterLayout() };
 
     using DSP_Order = std::array<DSP_Option, static_cast<size_t>(DSP_Option::END_OF_LIST)>;
-    SimpleMBComp::Fifo<DSP_Order> dspOrderFifo;
-
-    juce::AudioParameterFloat* phaserRateHz = nullptr;
-    juce::AudioParameterFloat* phaserCenterFreqHz = nullptr;
-    juce::AudioParameterFloat* phaserDepthPercent = nullptr;
-    juce::AudioParameterFloat* phaserFeedbackPercent = nullptr;
-    juce::AudioParameterFloat* phaserMixPercent = nullptr;
-    juce::AudioParameterBool* phaserBypass = nullptr;
-
-    juce::AudioParameterFloat* chorusRateHz = nullptr;
-    juce::AudioParameterFloat* chorusDepthPercent = nullptr;
-    juce::AudioParameterFloat* chorusCenterDelayMs = nullptr;
-    juce::AudioParameterFloat* chorusFeedbackPercent = nullptr;
-    juce::AudioParameterFloat* chorusMixPercent = nullptr;
-    juce::AudioParameterBool* chorusBypass= nullptr;
-
-    juce::AudioParameterFloat* overdriveSaturation = nullptr;
-    juce::AudioParameterBool* overdriveBypass = nullptr;
-
-    juce::AudioParameterChoice* ladderFilterMode = nullptr;
-    juce::AudioParameterFloat* ladderFilterCutoffHz = nullptr;
-    juce::AudioParameterFloat* ladderFilterResonance = nullptr;
-    juce::AudioParameterFloat* ladderFilterDrive = nullptr;
-    juce::AudioParameterBool* ladderFilterBypass = nullptr;
-
-    juce::AudioParameterChoice* generalFilterMode = nullptr;
-    juce::AudioParameterFloat*  generalilterFreqHz = nullptr;
-    juce::AudioParameterFloat*  generalilterQuality = nullptr;
-    juce::AudioParameterFloat*  generalilterGain = nullptr;
-    juce::AudioParameterBool*  generalFilterBypass = nullptr;
 
-    
+    /*
+        Multiband: the input can be split into up to maxBands bands with
+        Linkwitz-Riley crossovers, each running its own copy of the chain with
+        its own order and parameters. Band 0 is also the full-band chain when
+        multiband is off, and keeps the original parameter IDs.
+    */
+    static constexpr size_t maxBands = 4;
+
+    std::array<SimpleMBComp::Fifo<DSP_Order>, maxBands> dspOrderFifos;
+
+    /** Message-thread side of the order handoff: remembers what was last sent
+        through dspOrderFifos so the editor can show it, and tells open editors
+        when it changes (e.g. after a state restore).
+    */
+    void requestDSPOrder(size_t band, const DSP_Order& newOrder);
+    DSP_Order getRequestedDSPOrder(size_t band) const { return requestedDSPOrders[band]; }
+    juce::ChangeBroadcaster dspOrderBroadcaster;
+
+    /*
+        Every chain reads its values for the current sub-block from packed
+        arrays rather than from the parameters, so that preset morphing can
+        fill them with one vectorised pass. These enums are the layout of one
+        chain's slice of those arrays.
+    */
+    enum class ChainFloat {
+        PhaserRate,
+        PhaserCenterFreq,
+        PhaserDepth,
+        PhaserFeedback,
+        PhaserMix,
+        ChorusRate,
+        ChorusDepth,
+        ChorusCenterDelay,
+        ChorusFeedback,
+        ChorusMix,
+        OverdriveSaturation,
+        LadderFilterCutoff,
+        LadderFilterResonance,
+        LadderFilterDrive,
+        GeneralFilterFreq,
+        GeneralFilterQuality,
+        GeneralFilterGain,
+        DelayTime,
+        DelayFeedback,
+        DelayMix,
+        DelayLowCut,
+        DelayHighCut,
+        ConvolutionMix,
+        END_OF_LIST
+    };
+
+    enum class ChainDiscrete {
+        PhaserBypass,
+        ChorusBypass,
+        OverdriveBypass,
+        LadderFilterMode,
+        LadderFilterBypass,
+        GeneralFilterMode,
+        GeneralFilterBypass,
+        GeneralFilterTopology,
+        DelaySync,
+        DelayNote,
+        DelayPingPong,
+        DelayBypass,
+        ConvolutionBypass,
+        END_OF_LIST
+    };
+
+    static constexpr size_t numChainFloats = static_cast<size_t>(ChainFloat::END_OF_LIST);
+    static constexpr size_t numChainDiscretes = static_cast<size_t>(ChainDiscrete::END_OF_LIST);
+
+    struct ChainParameters
+    {
+        juce::AudioParameterFloat* phaserRateHz = nullptr;
+        juce::AudioParameterFloat* phaserCenterFreqHz = nullptr;
+        juce::AudioParameterFloat* phaserDepthPercent = nullptr;
+        juce::AudioParameterFloat* phaserFeedbackPercent = nullptr;
+        juce::AudioParameterFloat* phaserMixPercent = nullptr;
+        juce::AudioParameterBool* phaserBypass = nullptr;
+
+        juce::AudioParameterFloat* chorusRateHz = nullptr;
+        juce::AudioParameterFloat* chorusDepthPercent = nullptr;
+        juce::AudioParameterFloat* chorusCenterDelayMs = nullptr;
+        juce::AudioParameterFloat* chorusFeedbackPercent = nullptr;
+        juce::AudioParameterFloat* chorusMixPercent = nullptr;
+        juce::AudioParameterBool* chorusBypass= nullptr;
+
+        juce::AudioParameterFloat* overdriveSaturation = nullptr;
+        juce::AudioParameterBool* overdriveBypass = nullptr;
+
+        juce::AudioParameterChoice* ladderFilterMode = nullptr;
+        juce::AudioParameterFloat* ladderFilterCutoffHz = nullptr;
+        juce::AudioParameterFloat* ladderFilterResonance = nullptr;
+        juce::AudioParameterFloat* ladderFilterDrive = nullptr;
+        juce::AudioParameterBool* ladderFilterBypass = nullptr;
+
+        juce::AudioParameterChoice* generalFilterMode = nullptr;
+        juce::AudioParameterFloat*  generalilterFreqHz = nullptr;
+        juce::AudioParameterFloat*  generalilterQuality = nullptr;
+        juce::AudioParameterFloat*  generalilterGain = nullptr;
+        juce::AudioParameterBool*  generalFilterBypass = nullptr;
+        juce::AudioParameterChoice* generalFilterTopology = nullptr;
+
+        juce::AudioParameterFloat* delayTimeMs = nullptr;
+        juce::AudioParameterFloat* delayFeedbackPercent = nullptr;
+        juce::AudioParameterFloat* delayMixPercent = nullptr;
+        juce::AudioParameterFloat* delayLowCutHz = nullptr;
+        juce::AudioParameterFloat* delayHighCutHz = nullptr;
+        juce::AudioParameterBool* delaySync = nullptr;
+        juce::AudioParameterChoice* delayNoteDivision = nullptr;
+        juce::AudioParameterBool* delayPingPong = nullptr;
+        juce::AudioParameterBool* delayBypass = nullptr;
+
+        juce::AudioParameterFloat* convolutionMix = nullptr;
+        juce::AudioParameterBool* convolutionBypass = nullptr;
+
+        /** in ChainFloat order */
+        std::array<juce::AudioParameterFloat*, numChainFloats> getFloatParams() const;
+        /** in ChainDiscrete order */
+        std::array<juce::RangedAudioParameter*, numChainDiscretes> getDiscreteParams() const;
+    };
+
+    std::array<ChainParameters, maxBands> chainParams;
+
+    juce::AudioParameterChoice* multibandMode = nullptr;
+    juce::AudioParameterChoice* monoPath = nullptr;
+    std::array<juce::AudioParameterFloat*, maxBands - 1> crossoverFreqHz {};
+
+    /*
+        Preset morphing: capture up to four snapshots of every float, choice
+        and bool parameter (except the morph controls), then sweep morphPosition
+        to blend through them. While morphEnabled is on and two or more
+        snapshots exist, the chains ignore the live parameter values.
+    */
+    juce::AudioParameterFloat* morphPosition = nullptr;
+    juce::AudioParameterBool* morphEnabled = nullptr;
+
+    //packed layout: each band's chain slice in order, then crossovers / multiband mode
+    static constexpr size_t numPackedFloats = maxBands * numChainFloats + (maxBands - 1);
+    static constexpr size_t numPackedDiscretes = maxBands * numChainDiscretes + 1;
+
+    using Morpher = PresetMorpher<numPackedFloats, numPackedDiscretes>;
+
+    void captureMorphSnapshot(size_t slot);
+    void clearMorphSnapshot(size_t slot);
+    bool hasMorphSnapshot(size_t slot) const { return requestedMorphSnapshots.captured[slot]; }
+    juce::ChangeBroadcaster morphSnapshotBroadcaster;
+
+    /** Estimated bytes held by this instance's DSP: the processor itself plus
+        the heap of every stage and band buffer prepared so far. Stages are
+        only prepared once they are used, so this grows with the session.
+    */
+    size_t getDSPMemoryBytes() const;
+    juce::ChangeBroadcaster dspMemoryBroadcaster;
+
+    /** Message thread. Remembers the file and returns straight away; the
+        preparation thread decodes, resamples and partitions it, and each
+        band crossfades to it once it is built. Saved with the state.
+    */
+    void loadImpulseResponse(const juce::File& file);
+    juce::File getImpulseResponseFile() const;
+    /** convolution tail frames that missed their deadline or were lapped, over every band since prepareToPlay */
+    juce::int64 getNumDroppedTailFrames() const;
+
+    /** Blocks longer than this run through each band's chain one tile at a
+        time instead of one stage at a time, so a tile stays in L1 from the
+        first stage to the last. 0 runs whole blocks. The best size depends on
+        the CPU; GoldenRender::benchmarkTileSizes measures it.
+    */
+    static constexpr int defaultTileSize = 1024;
+    void setTileSize(int samples);
+    int getTileSize() const { return tileSize.load(std::memory_order_relaxed); }
+
+    /** Opt-in: while on, realtime blocks that come close to their deadline
+        step quality down (coarser morph and SVF control rates) until the
+        load drops again. Offline bounces always run at full quality.
+    */
+    juce::AudioParameterBool* adaptiveQuality = nullptr;
+    QualityGovernor::Level getQualityLevel() const { return qualityGovernor.getLevel(); }
+    /** sent from the preparation thread when the level or the dropped tail frame count changes */
+    juce::ChangeBroadcaster qualityBroadcaster;
+
 private:
     //==============================================================================
-    DSP_Order dspOrder;
+    std::array<DSP_Order, maxBands> requestedDSPOrders;
 
-    template<typename DSP>
-    struct DSP_Choice : juce::dsp::ProcessorBase
+    /** a chain's view of the packed values for the current sub-block */
+    struct ChainValues
     {
-        void prepare(const juce::dsp::ProcessSpec& spec) override {
-            dsp.prepare(spec);
-        }
-        void process(const juce::dsp::ProcessContextReplacing<float>& context) override {
-            dsp.process(context);
-        }
-        void reset() override {
-            dsp.reset();
-        }
-
-        DSP dsp;
+        const float* floats = nullptr;
+        const float* discretes = nullptr;
+
+        float get(ChainFloat f) const { return floats[static_cast<size_t>(f)]; }
+        int getIndex(ChainDiscrete d) const { return juce::roundToInt(discretes[static_cast<size_t>(d)]); }
+        bool isOn(ChainDiscrete d) const { return discretes[static_cast<size_t>(d)] >= 0.5f; }
     };
-    
-  struct MonoChannelDSP {
 
-    MonoChannelDSP(Project13_NewAudioProcessor& proc) : p(proc){}
-    
-    DSP_Choice<juce::dsp::DelayLine<float>> delay;
-    DSP_Choice<juce::dsp::Phaser<float>> phaser;
-    DSP_Choice<juce::dsp::Chorus<float>> chorus;
-    DSP_Choice<juce::dsp::LadderFilter<float>> overdrive, ladderFilter;
-    DSP_Choice<juce::dsp::IIR::Filter<float>> generalFilter;
+    std::array<juce::AudioParameterFloat*, numPackedFloats> packedFloatParams {};
+    std::array<juce::RangedAudioParameter*, numPackedDiscretes> packedDiscreteParams {};
+    std::array<float, numPackedFloats> packedFloats {};
+    std::array<float, numPackedDiscretes> packedDiscretes {};
+
+    /** reads the live parameters in packed order */
+    void readParamValues(float* floats, float* discretes) const;
+    float getPackedCrossover(size_t index) const { return packedFloats[maxBands * numChainFloats + index]; }
+    /** 1 when multiband is off, otherwise 2 to maxBands */
+    size_t getNumActiveBands() const;
+
+    Morpher morpher;
+    Morpher::SnapshotSet requestedMorphSnapshots;
+    CommandQueue<Morpher::SnapshotSet> morphSnapshotQueue;
+    /** message thread; queues a copy of requestedMorphSnapshots for the audio thread, retrying until it fits */
+    void publishMorphSnapshots();
+
+    /** publishes again while the queue is full, so the newest set always reaches the audio thread */
+    struct MorphSnapshotRetry : juce::Timer
+    {
+        explicit MorphSnapshotRetry(Project13_NewAudioProcessor& p) : owner(p) {}
+        void timerCallback() override { owner.publishMorphSnapshots(); }
+        Project13_NewAudioProcessor& owner;
+    };
+
+    static constexpr int morphSnapshotRetryMs = 50;
+    MorphSnapshotRetry morphSnapshotRetry { *this };
+    juce::SmoothedValue<float> smoothedMorphPosition;
+
+    /** morphing re-packs the values this often so sweeps stay smooth */
+    static constexpr int morphSubBlockSize = 32;
+
+    //what each quality level trades: how often morphing re-packs, the SVF makes coefficients and the chorus works out its LFO
+    static int getMorphSubBlockSize(QualityGovernor::Level level);
+    static int getSvfControlInterval(QualityGovernor::Level level);
+    static int getChorusControlInterval(QualityGovernor::Level level);
 
-    void prepare(const juce::dsp::ProcessSpec& spec);
+  /** one copy of the chain: its stages, its order and its multiband buffer */
+  struct BandChain
+  {
+    void process(juce::dsp::AudioBlock<float> block);
+
+    /** the stage that runs option's slot, with the general filter's current topology */
+    LazyStage* getStage(DSP_Option option);
+    /** every stage that can run option's slot; an unused entry is nullptr */
+    std::array<LazyStage*, 2> getStages(DSP_Option option);
+
+    //preparation side, never called on the audio thread
+    bool isStageWanted(DSP_Option option);
+    void prepareStage(DSP_Option option, const juce::dsp::ProcessSpec& spec);
+    void prepareBuffer(int numSamples);
+    void unprepare();
+    size_t getHeapBytes(const juce::dsp::ProcessSpec& spec) const;
+    bool isBypassed(DSP_Option option) const;
+    /** resets the stages that are prepared; never concurrent with process() */
+    void reset();
+    /** from prepareToPlay; the rate the biquad's coefficients are made for, and the scratch the stages fade in with */
+    void setSampleRate(double newSampleRate, int maximumBlockSize);
+    /** audio thread; true once per stage the band has asked for since the last call */
+    bool takeStageRequests();
+    bool usesSvf() const;
+
+    ChainValues values;
+    DSP_Order dspOrder;
+
+    StereoPhaser phaser;
+    StereoChorus chorus;
+    StereoLadder overdrive, ladderFilter;
+    //the general filter's two topologies
+    StereoBiquad generalFilter;
+    TptSvf svfFilter;
+    TempoDelay delay;
+    ConvolutionStage convolution;
+
+    double tempoBpm = 120.0;
+    int tileSize = defaultTileSize;
+    int svfControlInterval = 1;
+    int chorusControlInterval = 1;
+    bool monoPathEnabled = true;
+
+    //only allocated once the band is used by a multiband split
+    juce::AudioBuffer<float> buffer;
+    std::atomic<bool> bufferReady { false };
+    std::atomic<bool> bufferWanted { false };
+
+  private:
+    /** a stage whose channels differ by no more than this can run on the left alone and be copied */
+    static constexpr float monoStateTolerance = 1.0e-6f;
 
     void updateDSPFromParams();
+    void updateGeneralFilter();
+    void updateSvf();
+    void updateDelay();
+    /** runs the whole chain; with sidesIdentical, on the left alone for as long as every stage can */
+    void processTile(juce::dsp::AudioBlock<float> block, bool sidesIdentical);
+    /** leftOnly when block is the left channel of a band whose right one is being skipped */
+    void processStage(DSP_Option option, juce::dsp::AudioBlock<float> block, bool leftOnly);
+    /** whether option's slot can run on the left channel alone while the sides are the same */
+    bool canRunMono(DSP_Option option);
 
-    void process(juce::dsp::AudioBlock<float> block, const DSP_Order& dspOrder);
+    double sampleRate = 0.0;
+    //mode, freq, Q, gain the biquad coefficients were last made for
+    std::array<float, 4> lastFilterSettings {};
 
-    private:
-      Project13_NewAudioProcessor& p;
+    juce::AudioBuffer<float> fadeScratch;
+    //audio thread: set when a stage was asked for
+    bool stageRequested = false;
   };
 
+  std::array<BandChain, maxBands> bands;
 
-  MonoChannelDSP leftChannel {*this};
-  MonoChannelDSP rightChannel {*this};
-    
-    struct ProcessState
+  static_assert(maxBands == BandSplitter::maxBands, "splitter and chains must agree on the band count");
+  BandSplitter bandSplitter;
+  juce::SharedResourcePointer<BandWorkerPool> bandWorkers;
+  int preparedBlockSize = 0;
+
+  /** from the host playhead, for tempo-synced delays; kept when the host stops reporting it */
+  double hostBpm = 120.0;
+  std::atomic<int> tileSize { defaultTileSize };
+
+  QualityGovernor qualityGovernor;
+  //preparation thread
+  QualityGovernor::Level reportedQualityLevel = QualityGovernor::Level::Full;
+  juce::int64 reportedDroppedTailFrames = 0;
+  //audio thread: what the preparation thread was last woken to report
+  QualityGovernor::Level signalledQualityLevel = QualityGovernor::Level::Full;
+  juce::int64 signalledDroppedTailFrames = 0;
+  bool bufferRequested = false;
+
+  /** blocks at least this long are worth handing to the worker pool in realtime */
+  static constexpr int parallelBandsMinSamples = 1024;
+
+  /** the whole host block; when morphing, every chain re-packs its values each currentMorphStep samples */
+  void processChains(juce::dsp::AudioBlock<float> block);
+  /** band 0 alone over the full band, following the morph sweep on the audio thread */
+  void processFullBand(juce::dsp::AudioBlock<float> block);
+  /** one band of a multiband chunk, re-packing only its own slice per sub-block; runs on a band worker */
+  void processBand(size_t band, juce::dsp::AudioBlock<float> block);
+  /** 0 when this host block isn't morphing */
+  int currentMorphStep = 0;
+  //the morph position of each sub-block in the current multiband chunk, for the band workers
+  std::vector<float> morphPositions;
+  void processMultiband(juce::dsp::AudioBlock<float> block, size_t numBands);
+  void cacheChainParams(ChainParameters& params, const juce::String& prefix);
+
+  /*
+      Stages and band buffers are prepared the first time they are needed
+      rather than all up front in prepareToPlay. The audio thread marks what it
+      is missing and wakes the shared preparation thread, whose pass for this
+      instance prepares it with the spec from the last prepareToPlay.
+  */
+  struct StagePreparer : LazyPreparationThread::Client
   {
-    juce::dsp::ProcessorBase* processor = nullptr;
-    bool bypassed = false;
+    explicit StagePreparer(Project13_NewAudioProcessor& p) : owner(p) {}
+    void runPreparationPass() override { owner.prepareWantedStages(); }
+    Project13_NewAudioProcessor& owner;
   };
-    using DSP_Pointers = std::array<ProcessState, static_cast<size_t>(DSP_Option::END_OF_LIST)>;
+
+  void prepareWantedStages();
+  /** builds the loaded impulse response for every band whose convolution is prepared but out of date */
+  void buildImpulseResponses();
+  /** prepares whatever the current values switch on; never called from a realtime block */
+  void prepareActiveStages();
+  /** audio thread, lock-free; whether prepareActiveStages() has anything to do */
+  bool hasUnpreparedActiveStages();
+  /** audio thread, end of block; wakes the preparation thread for new requests, quality changes and dropouts */
+  void requestPreparationIfNeeded();
+
+  juce::CriticalSection preparationLock;
+  juce::dsp::ProcessSpec stageSpec { 0.0, 0, 1 };
+  juce::SharedResourcePointer<LazyPreparationThread> preparationThread;
+  StagePreparer stagePreparer { *this };
+
+ #if PROJECT13_TRACING
+  //keeps the process-wide trace alive while this instance can record into it
+  juce::SharedResourcePointer<TimelineTrace> timelineTrace;
+ #endif
+
+  //guarded by preparationLock; the generation changes with every load
+  juce::File impulseResponseFile;
+  int impulseResponseGeneration = 0;
 
   JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (Project13_NewAudioProcessor)
   
   template<typename ParamType, typename Params, typename Funcs>
-  void initCachedParams(Params paramsArray, Funcs funcsArray){
+  void initCachedParams(Params paramsArray, Funcs funcsArray, const juce::String& prefix = {}){
     
     for (size_t i = 0; i < paramsArray.size(); ++i)
     {
         auto ptrToParamPtr = paramsArray[i];
-        *ptrToParamPtr = dynamic_cast<ParamType>(apvts.getParameter(funcsArray[i]()));
+        *ptrToParamPtr = dynamic_cast<ParamType>(apvts.getParameter(prefix + funcsArray[i]()));
         jassert(*ptrToParamPtr != nullptr);
     }
   }
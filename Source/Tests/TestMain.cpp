@@ -0,0 +1,91 @@
+/*
+  ==============================================================================
+
+    TestMain.cpp
+    Project13_Tests: runs the Project13 unit tests and exits non-zero if any
+    of them failed, so a build script or CI job can gate on it.
+
+  ==============================================================================
+*/
+
+#include <JuceHeader.h>
+#include "../Diagnostics/GoldenRender.h"
+
+#include <iostream>
+
+#if ! JUCE_UNIT_TESTS
+ #error "Project13_Tests must be built with JUCE_UNIT_TESTS=1"
+#endif
+
+namespace
+{
+    constexpr auto usage =
+        "Project13_Tests [options]\n"
+        "  --test=<name>      run only the test with this name, e.g. \"Golden output\"\n"
+        "  --list             list the tests and exit\n"
+        "  --golden-dir=<dir> compare against the golden files in dir, e.g. Tests/Golden\n"
+        "  --record-golden    write the current renders as the golden files instead of comparing\n";
+
+    constexpr auto category = "Project13";
+
+    /** prints as it goes rather than through the debug logger, so CI logs show progress */
+    struct ConsoleRunner : juce::UnitTestRunner
+    {
+        void logMessage(const juce::String& message) override
+        {
+            std::cout << message << std::endl;
+        }
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    if (args.containsOption("--help|-h"))
+    {
+        std::cerr << usage;
+        return 0;
+    }
+
+    auto tests = juce::UnitTest::getTestsInCategory(category);
+
+    if (args.containsOption("--list"))
+    {
+        for (auto* test : tests)
+            std::cout << test->getName() << std::endl;
+
+        return 0;
+    }
+
+    if (args.containsOption("--test"))
+    {
+        auto name = args.getValueForOption("--test");
+        tests.removeIf([&name](juce::UnitTest* test) { return test->getName() != name; });
+
+        if (tests.isEmpty())
+        {
+            std::cerr << "no test named " << name << std::endl;
+            return 1;
+        }
+    }
+
+    //relative to where the runner was started, like any other path argument
+    if (args.containsOption("--golden-dir"))
+        GoldenRender::setGoldenDirectory(args.getFileForOption("--golden-dir"));
+
+    GoldenRender::setRecording(args.containsOption("--record-golden"));
+
+    ConsoleRunner runner;
+    runner.setAssertOnFailure(false);
+    runner.runTests(tests);
+
+    auto failures = 0;
+
+    for (int i = 0; i < runner.getNumResults(); ++i)
+        failures += runner.getResult(i)->failures;
+
+    std::cout << (failures == 0 ? "all tests passed" : juce::String(failures) + " failures") << std::endl;
+    return failures == 0 ? 0 : 1;
+}